@@ -0,0 +1,122 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+using namespace std;
+// alignment of every allocation, one cache line
+#define ARENA_ALIGN 64
+// bump allocator for scratch arrays that live as long as their owner: alloc is a pointer
+// bump, reset rewinds without freeing and folds the blocks into one so the next round of
+// the same sizes fits in a single block
+class Arena{
+public:
+    Arena(size_t blockSize=1<<16){
+        this->blockSize = blockSize;
+        current = 0;
+        used = 0;
+    }
+    ~Arena(){
+        release();
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    Arena(Arena&& other){
+        take(other);
+    }
+    Arena& operator=(Arena&& other){
+        if(this!=&other){
+            release();
+            take(other);
+        }
+        return *this;
+    }
+    template<typename T>
+    T* alloc(size_t n){
+        size_t bytes = (n*sizeof(T)+ARENA_ALIGN-1)/ARENA_ALIGN*ARENA_ALIGN;
+        while(current<blocks.size() && used+bytes>blocks[current].size){
+            current++;
+            used = 0;
+        }
+        if(current==blocks.size()){
+            addBlock(bytes>blockSize ? bytes : blockSize);
+            used = 0;
+        }
+        T* p = reinterpret_cast<T*>(blocks[current].data+used);
+        used += bytes;
+        return p;
+    }
+    // everything handed out before is invalid afterwards
+    void reset(){
+        if(blocks.size()>1){
+            size_t total = 0;
+            for(unsigned int i=0;i<blocks.size();i++){
+                total += blocks[i].size;
+            }
+            release();
+            addBlock(total);
+        }
+        current = 0;
+        used = 0;
+    }
+    size_t capacity() const{
+        size_t total = 0;
+        for(unsigned int i=0;i<blocks.size();i++){
+            total += blocks[i].size;
+        }
+        return total;
+    }
+private:
+    struct Block{
+        char* data;
+        size_t size;
+    };
+    vector<Block> blocks;
+    size_t blockSize;
+    size_t current;
+    size_t used;
+
+    void addBlock(size_t bytes){
+        void* p = NULL;
+#ifdef _WIN32
+        p = _aligned_malloc(bytes, ARENA_ALIGN);
+#else
+        if(posix_memalign(&p, ARENA_ALIGN, bytes)!=0){
+            p = NULL;
+        }
+#endif
+        if(!p){
+            throw bad_alloc();
+        }
+        Block block;
+        block.data = static_cast<char*>(p);
+        block.size = bytes;
+        blocks.push_back(block);
+    }
+    void release(){
+        for(unsigned int i=0;i<blocks.size();i++){
+#ifdef _WIN32
+            _aligned_free(blocks[i].data);
+#else
+            free(blocks[i].data);
+#endif
+        }
+        blocks.clear();
+        current = 0;
+        used = 0;
+    }
+    void take(Arena& other){
+        blocks.swap(other.blocks);
+        other.blocks.clear();
+        blockSize = other.blockSize;
+        current = other.current;
+        used = other.used;
+        other.current = 0;
+        other.used = 0;
+    }
+};
+#endif
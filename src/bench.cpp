@@ -0,0 +1,299 @@
+#include "meshgen.h"
+#include "model.h"
+#include "threadpool.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+
+// microbenchmarks of the decomposition phases on generated meshes:
+// meshdecomp_bench [--shapes torus,eight,handles] [--sizes 1000,10000,100000] [--reps 3]
+//                  [--threads n] [--floyd-limit 2048] [--ff-limit 8192] [--csv f] [--json f]
+
+struct BenchResult{
+    string name;
+    string shape;
+    unsigned int faces;
+    unsigned int reps;
+    double min;
+    double median;
+    double mean;
+};
+
+static vector<BenchResult> results;
+// keeps the distance loops from being optimized away
+static volatile float sink;
+
+static double seconds(chrono::steady_clock::time_point start){
+    return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+// setup runs before every repetition and is not timed
+template<typename Setup, typename Body>
+static void measure(const string& name, const string& shape, unsigned int faces, unsigned int reps, Setup setup, Body body){
+    vector<double> times;
+    for(unsigned int r=0;r<reps;r++){
+        setup();
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        body();
+        times.push_back(seconds(start));
+    }
+    sort(times.begin(), times.end());
+    BenchResult result;
+    result.name = name;
+    result.shape = shape;
+    result.faces = faces;
+    result.reps = reps;
+    result.min = times[0];
+    result.median = times[times.size()/2];
+    result.mean = 0;
+    for(unsigned int r=0;r<times.size();r++){
+        result.mean += times[r]/times.size();
+    }
+    results.push_back(result);
+    cout<<shape<<"\t"<<faces<<"\t"<<name<<"\t"<<result.median<<" s"<<endl;
+}
+
+template<typename Body>
+static void measure(const string& name, const string& shape, unsigned int faces, unsigned int reps, Body body){
+    measure(name, shape, faces, reps, []{}, body);
+}
+
+static vector<string> split(const string& s){
+    vector<string> parts;
+    stringstream in(s);
+    string part;
+    while(getline(in, part, ',')){
+        if(!part.empty()){
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+static void benchShape(const string& shape, unsigned int target, unsigned int reps, unsigned int floydLimit, unsigned int ffLimit){
+    Mesh mesh = MeshGenerator::generate(shape, target);
+    unsigned int N = mesh.faces.size();
+    measure("generate", shape, N, reps, [&]{
+        MeshGenerator::generate(shape, target);
+    });
+
+    // loader: assimp import and processMesh of the obj written by the generator
+    string path = "meshdecomp_bench_"+shape+".obj";
+    if(MeshGenerator::saveObj(mesh, path)){
+        measure("loader", shape, N, reps, [&]{
+            Model model(path);
+        });
+        remove(path.c_str());
+    }
+
+    measure("dualBuild", shape, N, reps, [&]{
+        DualBuilder builder;
+        builder.build(mesh.indices, mesh.dual, mesh.dualReport);
+    });
+
+    unsigned int E = mesh.dual.edgeCount();
+    Decomposition& machine = mesh.decompositionMachine;
+    measure("calcAngDistance", shape, N, reps, [&]{
+        float sum = 0;
+        for(unsigned int e=0;e<E;e++){
+            sum += machine.calcAngDistance(mesh.faces[mesh.dual.left[e]].Normal, mesh.faces[mesh.dual.right[e]].Normal,
+                mesh.vertices[mesh.dual.begin[e]].Position, mesh.vertices[mesh.dual.end[e]].Position,
+                mesh.vertices[mesh.dual.leftv[e]].Position, mesh.vertices[mesh.dual.rightv[e]].Position);
+        }
+        sink = sum;
+    });
+    measure("calcGeoDistance", shape, N, reps, [&]{
+        float sum = 0;
+        for(unsigned int e=0;e<E;e++){
+            sum += machine.calcGeoDistance(mesh.vertices[mesh.dual.begin[e]].Position, mesh.vertices[mesh.dual.end[e]].Position,
+                mesh.vertices[mesh.dual.leftv[e]].Position, mesh.vertices[mesh.dual.rightv[e]].Position);
+        }
+        sink = sum;
+    });
+    measure("initWeights", shape, N, reps, [&]{
+        mesh.initWeights();
+    });
+
+    if(N<=floydLimit){
+        mesh.distanceMode = DENSE_FLOYD;
+        measure("floyd", shape, N, reps, [&]{
+            mesh.initWeights();
+        }, [&]{
+            mesh.calcWeights();
+        });
+        mesh.distanceMode = SPARSE_DIJKSTRA;
+        mesh.initWeights();
+    }
+
+    measure("dijkstra", shape, N, reps, [&]{
+        machine.dijkstra(mesh.dual, 0, mesh.scratchRow.data());
+    });
+    measure("initProbs", shape, N, reps, [&]{
+        mesh.distanceRows.clear();
+    }, [&]{
+        mesh.initProbs(2);
+    });
+    // farthest point seeds of eight patches, one row per seed
+    measure("farthestSeeds", shape, N, reps, [&]{
+        mesh.distanceRows.clear();
+    }, [&]{
+        mesh.initProbs(8);
+    });
+    // memberships of 32 patches kept as the top slots of every face
+    measure("topMemberships", shape, N, reps, [&]{
+        mesh.initProbs(32);
+    }, [&]{
+        mesh.prob(mesh.probs, 32);
+    });
+
+    // from the seeds of initProbs every repetition
+    measure("rep", shape, N, reps, [&]{
+        mesh.initProbs(2);
+    }, [&]{
+        mesh.rep(mesh.probs, 2);
+    });
+
+    measure("fuzzyConstruct", shape, N, reps, [&]{
+        mesh.fuzzyConstruct(0.01);
+    });
+    int s = mesh.A.size()+mesh.B.size()+mesh.C.size();
+    // FordFulkerson keeps dense matrices, skip fuzzy regions that would not fit
+    if(mesh.fuzzyNodes<=ffLimit){
+        FordFulkerson* gr = NULL;
+        measure("ff", shape, N, reps, [&]{
+            delete gr;
+            gr = new FordFulkerson(mesh.fuzzyNodes, mesh.fuzzyEdges);
+        }, [&]{
+            gr->ff(s, s+1);
+        });
+        measure("cut", shape, N, reps, [&]{
+            gr->cut(s, s+1);
+        });
+        delete gr;
+    }else{
+        cout<<shape<<"\t"<<N<<"\tfuzzy region of "<<mesh.fuzzyNodes<<" nodes, skipping ff/cut"<<endl;
+    }
+    BoykovKolmogorov bk(mesh.fuzzyNodes, mesh.fuzzyEdges);
+    measure("bk", shape, N, reps, [&]{
+        bk.ff(s, s+1);
+    });
+    PushRelabel pr(mesh.fuzzyNodes, mesh.fuzzyEdges);
+    measure("pushRelabel", shape, N, reps, [&]{
+        pr.ff(s, s+1);
+    });
+    Dinic dinic(mesh.fuzzyNodes, mesh.fuzzyEdges);
+    measure("dinic", shape, N, reps, [&]{
+        dinic.ff(s, s+1);
+    });
+    ParallelPushRelabel ppr(mesh.fuzzyNodes, mesh.fuzzyEdges);
+    measure("parallelPushRelabel", shape, N, reps, [&]{
+        ppr.ff(s, s+1);
+    });
+    // the same graph with capacities quantised like --capacity int64
+    BasicBoykovKolmogorov<long long> bkInt;
+    measure("quantize", shape, N, reps, [&]{
+        bkInt.graph.quantize(bk.graph, mesh.capacityScale, s, s+1);
+    });
+    measure("bkInt64", shape, N, reps, [&]{
+        bkInt.ff(s, s+1);
+    });
+    BasicDinic<long long> dinicInt;
+    dinicInt.graph = bkInt.graph;
+    dinicInt.scaling = true;
+    measure("dinicScaling", shape, N, reps, [&]{
+        dinicInt.ff(s, s+1);
+    });
+    // both patches refined together, from the types of initProbs every repetition
+    vector<unsigned int> types(N);
+    for(unsigned int i=0;i<N;i++){
+        types[i] = mesh.faces[i].type;
+    }
+    measure("expansion", shape, N, reps, [&]{
+        for(unsigned int i=0;i<N;i++){
+            mesh.faces[i].type = types[i];
+        }
+    }, [&]{
+        mesh.fuzzyExpansion(2);
+    });
+}
+
+static void saveCsv(const string& path){
+    ofstream out(path);
+    out<<"benchmark,shape,faces,reps,min_s,median_s,mean_s"<<endl;
+    for(unsigned int i=0;i<results.size();i++){
+        const BenchResult& r = results[i];
+        out<<r.name<<","<<r.shape<<","<<r.faces<<","<<r.reps<<","<<r.min<<","<<r.median<<","<<r.mean<<endl;
+    }
+}
+
+static void saveJson(const string& path, unsigned int threads){
+    ofstream out(path);
+    out<<"{\n  \"threads\": "<<threads<<",\n  \"results\": [";
+    for(unsigned int i=0;i<results.size();i++){
+        const BenchResult& r = results[i];
+        out<<(i ? ",\n" : "\n");
+        out<<"    {\"benchmark\": \""<<r.name<<"\", \"shape\": \""<<r.shape<<"\", \"faces\": "<<r.faces
+           <<", \"reps\": "<<r.reps<<", \"min_s\": "<<r.min<<", \"median_s\": "<<r.median<<", \"mean_s\": "<<r.mean<<"}";
+    }
+    out<<"\n  ]\n}"<<endl;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> shapes = split("torus,eight,handles");
+    vector<string> sizes = split("1000,10000,100000");
+    unsigned int reps = 3;
+    unsigned int threads = 0;
+    unsigned int floydLimit = 2048;
+    unsigned int ffLimit = 8192;
+    string csv;
+    string json;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(i+1>=argc){
+            cout<<"missing value for "<<arg<<endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if(arg=="--shapes"){
+            shapes = split(value);
+        }else if(arg=="--sizes"){
+            sizes = split(value);
+        }else if(arg=="--reps"){
+            reps = max(1, atoi(value.c_str()));
+        }else if(arg=="--threads"){
+            threads = atoi(value.c_str());
+        }else if(arg=="--floyd-limit"){
+            floydLimit = atoi(value.c_str());
+        }else if(arg=="--ff-limit"){
+            ffLimit = atoi(value.c_str());
+        }else if(arg=="--csv"){
+            csv = value;
+        }else if(arg=="--json"){
+            json = value;
+        }else{
+            cout<<"unknown option "<<arg<<endl;
+            return 2;
+        }
+    }
+    ThreadPool::configure(threads);
+    threads = ThreadPool::global().size();
+    cout<<"threads "<<threads<<", reps "<<reps<<endl;
+    for(unsigned int i=0;i<shapes.size();i++){
+        for(unsigned int j=0;j<sizes.size();j++){
+            benchShape(shapes[i], atoi(sizes[j].c_str()), reps, floydLimit, ffLimit);
+        }
+    }
+    if(!csv.empty()){
+        saveCsv(csv);
+    }
+    if(!json.empty()){
+        saveJson(json, threads);
+    }
+    return 0;
+}
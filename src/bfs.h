@@ -0,0 +1,178 @@
+#ifndef BFS_H
+#define BFS_H
+#include <vector>
+#include <atomic>
+#include <algorithm>
+#include "threadpool.h"
+using namespace std;
+// parent of the nodes not reached
+#define BFS_NONE 0xffffffffu
+// frontier sizes below this expand on the calling thread
+#define BFS_PARALLEL_GRAIN 1024
+// residual arcs of a csr graph (offsets/heads/twins/residual, see FlowGraph): out walks
+// the arcs leaving u with capacity, in the arcs entering v with capacity
+template<typename Graph>
+struct ResidualView{
+    const Graph& graph;
+    ResidualView(const Graph& graph) : graph(graph){}
+    unsigned int size() const{
+        return graph.size();
+    }
+    unsigned int degree(unsigned int v) const{
+        return graph.end(v)-graph.begin(v);
+    }
+    template<typename Visit>
+    void out(unsigned int u, Visit visit) const{
+        for(unsigned int a=graph.begin(u);a<graph.end(u);a++){
+            if(graph.residual[a]>0){
+                visit(graph.heads[a]);
+            }
+        }
+    }
+    // stops at the first neighbour visit accepts
+    template<typename Visit>
+    void in(unsigned int v, Visit visit) const{
+        for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+            if(graph.residual[graph.twins[a]]>0 && visit(graph.heads[a])){
+                return;
+            }
+        }
+    }
+};
+// level synchronous bfs with a flat frontier array and visited bitsets. A level expands
+// top-down from the frontier, or bottom-up from the unvisited nodes once the frontier's
+// arcs outnumber the unvisited ones (direction optimising bfs), and large levels are
+// split over the global thread pool. The tree does not depend on the threads: top-down
+// keeps the smallest frontier parent, bottom-up the first one in arc order, and every
+// level is sorted
+class FrontierBfs{
+public:
+    // reached nodes in level order, and the node each was reached from
+    vector<unsigned int> order;
+    unsigned int topDownLevels;
+    unsigned int bottomUpLevels;
+
+    FrontierBfs(){
+        topDownLevels = 0;
+        bottomUpLevels = 0;
+    }
+    unsigned int parent(unsigned int v) const{
+        return parents[v].load(memory_order_relaxed);
+    }
+    bool reached(unsigned int v) const{
+        return (visited[v>>6].load(memory_order_relaxed)>>(v&63))&1;
+    }
+    // bfs from s, stopping after the level that reaches d; returns whether d was reached
+    template<typename View>
+    bool run(const View& view, unsigned int s, unsigned int d=BFS_NONE){
+        ThreadPool& pool = ThreadPool::global();
+        unsigned int n = view.size();
+        reset(n);
+        order.clear();
+        topDownLevels = 0;
+        bottomUpLevels = 0;
+        mark(visited, s);
+        parents[s] = s;
+        order.push_back(s);
+        // frontier is order[levelBegin, order.size())
+        unsigned int levelBegin = 0;
+        unsigned long long unvisitedArcs = 0;
+        for(unsigned int v=0;v<n;v++){
+            unvisitedArcs += view.degree(v);
+        }
+        unvisitedArcs -= view.degree(s);
+        vector<vector<unsigned int>> next(pool.size());
+        while(levelBegin<order.size() && !(d<n && reached(d))){
+            unsigned int levelEnd = order.size();
+            unsigned long long frontierArcs = 0;
+            for(unsigned int i=levelBegin;i<levelEnd;i++){
+                frontierArcs += view.degree(order[i]);
+            }
+            for(unsigned int t=0;t<next.size();t++){
+                next[t].clear();
+            }
+            // beamer's heuristic: bottom-up while the frontier is heavy, alpha 14 beta 24
+            bool bottomUp = frontierArcs*14>unvisitedArcs && (unsigned long long)(levelEnd-levelBegin)*24>n;
+            if(bottomUp){
+                bottomUpLevels++;
+                clear(frontier);
+                for(unsigned int i=levelBegin;i<levelEnd;i++){
+                    mark(frontier, order[i]);
+                }
+                pool.parallelFor(0, n, 4*BFS_PARALLEL_GRAIN, [&](unsigned int begin, unsigned int end, unsigned int worker){
+                    for(unsigned int v=begin;v<end;v++){
+                        if(reached(v)){
+                            continue;
+                        }
+                        view.in(v, [&](unsigned int u){
+                            if(!((frontier[u>>6].load(memory_order_relaxed)>>(u&63))&1)){
+                                return false;
+                            }
+                            parents[v].store(u, memory_order_relaxed);
+                            next[worker].push_back(v);
+                            return true;
+                        });
+                    }
+                });
+            }else{
+                topDownLevels++;
+                pool.parallelFor(levelBegin, levelEnd, BFS_PARALLEL_GRAIN, [&](unsigned int begin, unsigned int end, unsigned int worker){
+                    for(unsigned int i=begin;i<end;i++){
+                        unsigned int u = order[i];
+                        view.out(u, [&](unsigned int v){
+                            if(reached(v)){
+                                return;
+                            }
+                            // the smallest frontier parent wins, whichever thread is first
+                            unsigned int old = parents[v].load(memory_order_relaxed);
+                            while(u<old && !parents[v].compare_exchange_weak(old, u, memory_order_relaxed)){
+                            }
+                            if(old==BFS_NONE){
+                                next[worker].push_back(v);
+                            }
+                        });
+                    }
+                });
+            }
+            levelBegin = levelEnd;
+            for(unsigned int t=0;t<next.size();t++){
+                order.insert(order.end(), next[t].begin(), next[t].end());
+            }
+            sort(order.begin()+levelBegin, order.end());
+            for(unsigned int i=levelBegin;i<order.size();i++){
+                mark(visited, order[i]);
+                unvisitedArcs -= view.degree(order[i]);
+            }
+        }
+        return d<n && reached(d);
+    }
+private:
+    vector<atomic<unsigned long long>> visited;
+    vector<atomic<unsigned long long>> frontier;
+    vector<atomic<unsigned int>> parents;
+
+    void reset(unsigned int n){
+        unsigned int words = (n+63)/64;
+        if(visited.size()!=words){
+            visited = vector<atomic<unsigned long long>>(words);
+            frontier = vector<atomic<unsigned long long>>(words);
+        }
+        if(parents.size()!=n){
+            parents = vector<atomic<unsigned int>>(n);
+        }
+        clear(visited);
+        for(unsigned int v=0;v<n;v++){
+            parents[v].store(BFS_NONE, memory_order_relaxed);
+        }
+    }
+    static void clear(vector<atomic<unsigned long long>>& bits){
+        for(unsigned int i=0;i<bits.size();i++){
+            bits[i].store(0, memory_order_relaxed);
+        }
+    }
+    // only called between levels, on the calling thread
+    static void mark(vector<atomic<unsigned long long>>& bits, unsigned int v){
+        bits[v>>6].store(bits[v>>6].load(memory_order_relaxed)|(1ull<<(v&63)), memory_order_relaxed);
+    }
+};
+#endif
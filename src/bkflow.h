@@ -0,0 +1,297 @@
+#ifndef BKFLOW_H
+#define BKFLOW_H
+#include <vector>
+#include <deque>
+#include <cstring>
+#include "flowgraph.h"
+#include "arena.h"
+using namespace std;
+// parent of a free node or of an orphan
+#define BK_NONE 0xffffffffu
+// parent of the terminals
+#define BK_ROOT 0xfffffffeu
+// boykov-kolmogorov max flow: a search tree grows from each terminal, after an
+// augmentation the trees are repaired by adopting the orphans instead of searching
+// again from scratch; same ff/cut interface as FordFulkerson.
+// a solver object is also a reusable workspace: the node state lives in an arena that
+// only grows, and is epoch stamped so a solve initializes just the nodes it reaches;
+// the residual arcs changed by the previous solve are restored the same way
+template<typename Cap>
+class BasicBoykovKolmogorov{
+public:
+    BasicFlowGraph<Cap> graph;
+    // augmenting paths found by the last ff
+    unsigned int augmentations;
+    // nodes reached by the last ff
+    unsigned int touchedNodes;
+
+    BasicBoykovKolmogorov(){
+        init();
+    }
+    BasicBoykovKolmogorov(const Matrix<float>& distance){
+        init();
+        graph.build(distance);
+    }
+    BasicBoykovKolmogorov(unsigned int n, const vector<FlowEdge>& edges){
+        init();
+        graph.build(n, edges);
+    }
+    void ff(int s, int d){
+        graph.restore();
+        resume(s, d);
+    }
+    // max flow on top of the flow already in the residual graph, which only has to be
+    // feasible: a warm start after capacities changed through graph.touch
+    void resume(int s, int d){
+        reserve(graph.size());
+        nextEpoch();
+        actives.clear();
+        orphans.clear();
+        augmentations = 0;
+        touchedNodes = 0;
+        node(s);
+        node(d);
+        tree[s] = SOURCE;
+        tree[d] = SINK;
+        parent[s] = BK_ROOT;
+        parent[d] = BK_ROOT;
+        setActive(s);
+        setActive(d);
+        while(true){
+            unsigned int middle = grow();
+            if(middle==BK_NONE){
+                break;
+            }
+            time++;
+            augment(middle);
+            adopt();
+            augmentations++;
+        }
+    }
+    vector<int> cut(int s, int d){
+        return graph.sourceSide(s, d);
+    }
+private:
+    enum{FREE = 0, SOURCE = 1, SINK = 2};
+    Arena arena;
+    unsigned int nodeCapacity;
+    // the state of v is valid only when mark[v] is the current epoch, see node
+    unsigned int* mark;
+    unsigned int epoch;
+    unsigned char* tree;
+    unsigned char* active;
+    // arc from the node to its parent in its tree
+    unsigned int* parent;
+    // distance to the root, valid when stamp is the current time; time keeps running
+    // across solves so old stamps never match
+    unsigned int* stamp;
+    unsigned int* dist;
+    deque<unsigned int> actives;
+    deque<unsigned int> orphans;
+    unsigned int time;
+
+    void init(){
+        augmentations = 0;
+        touchedNodes = 0;
+        nodeCapacity = 0;
+        mark = NULL;
+        epoch = 0;
+        tree = NULL;
+        active = NULL;
+        parent = NULL;
+        stamp = NULL;
+        dist = NULL;
+        time = 0;
+    }
+    // grow the node arrays, doubling so a sequence of growing graphs stays cheap
+    void reserve(unsigned int n){
+        if(n<=nodeCapacity){
+            return;
+        }
+        nodeCapacity = max(n, nodeCapacity*2);
+        arena.reset();
+        mark = arena.alloc<unsigned int>(nodeCapacity);
+        parent = arena.alloc<unsigned int>(nodeCapacity);
+        stamp = arena.alloc<unsigned int>(nodeCapacity);
+        dist = arena.alloc<unsigned int>(nodeCapacity);
+        tree = arena.alloc<unsigned char>(nodeCapacity);
+        active = arena.alloc<unsigned char>(nodeCapacity);
+        memset(mark, 0, nodeCapacity*sizeof(unsigned int));
+        epoch = 0;
+    }
+    void nextEpoch(){
+        epoch++;
+        if(epoch==0){
+            memset(mark, 0, nodeCapacity*sizeof(unsigned int));
+            epoch = 1;
+        }
+    }
+    // first use of v in this solve: a free node
+    void node(unsigned int v){
+        if(mark[v]!=epoch){
+            mark[v] = epoch;
+            tree[v] = FREE;
+            active[v] = 0;
+            parent[v] = BK_NONE;
+            stamp[v] = 0;
+            dist[v] = 0;
+            touchedNodes++;
+        }
+    }
+
+    void setActive(unsigned int v){
+        if(!active[v]){
+            active[v] = 1;
+            actives.push_back(v);
+        }
+    }
+    // residual capacity in the direction the tree grows, away from the root
+    Cap treeResidual(unsigned char t, unsigned int a){
+        return t==SOURCE ? graph.residual[a] : graph.residual[graph.twins[a]];
+    }
+    // returns the arc from the source tree to the sink tree, or BK_NONE
+    unsigned int grow(){
+        while(!actives.empty()){
+            unsigned int p = actives.front();
+            if(tree[p]!=FREE){
+                for(unsigned int a=graph.begin(p);a<graph.end(p);a++){
+                    if(treeResidual(tree[p], a)<=0){
+                        continue;
+                    }
+                    unsigned int q = graph.heads[a];
+                    node(q);
+                    if(tree[q]==FREE){
+                        tree[q] = tree[p];
+                        parent[q] = graph.twins[a];
+                        stamp[q] = stamp[p];
+                        dist[q] = dist[p]+1;
+                        setActive(q);
+                    }else if(tree[q]!=tree[p]){
+                        // p stays at the front and is scanned again after the repair
+                        return tree[p]==SOURCE ? a : graph.twins[a];
+                    }
+                }
+            }
+            actives.pop_front();
+            active[p] = 0;
+        }
+        return BK_NONE;
+    }
+    void augment(unsigned int middle){
+        vector<Cap>& residual = graph.residual;
+        unsigned int x = graph.heads[graph.twins[middle]];
+        unsigned int y = graph.heads[middle];
+        Cap f = residual[middle];
+        // bottleneck: source side flows parent -> child, sink side child -> parent
+        for(unsigned int v=x;parent[v]!=BK_ROOT;v=graph.heads[parent[v]]){
+            f = min(f, residual[graph.twins[parent[v]]]);
+        }
+        for(unsigned int v=y;parent[v]!=BK_ROOT;v=graph.heads[parent[v]]){
+            f = min(f, residual[parent[v]]);
+        }
+        graph.touch(middle);
+        residual[middle] -= f;
+        residual[graph.twins[middle]] += f;
+        for(unsigned int v=x;parent[v]!=BK_ROOT;){
+            unsigned int a = parent[v];
+            unsigned int next = graph.heads[a];
+            graph.touch(a);
+            residual[graph.twins[a]] -= f;
+            residual[a] += f;
+            if(residual[graph.twins[a]]<=0){
+                parent[v] = BK_NONE;
+                orphans.push_back(v);
+            }
+            v = next;
+        }
+        for(unsigned int v=y;parent[v]!=BK_ROOT;){
+            unsigned int a = parent[v];
+            unsigned int next = graph.heads[a];
+            graph.touch(a);
+            residual[a] -= f;
+            residual[graph.twins[a]] += f;
+            if(residual[a]<=0){
+                parent[v] = BK_NONE;
+                orphans.push_back(v);
+            }
+            v = next;
+        }
+    }
+    // distance from q to its root, or BK_NONE if its chain ends in an orphan
+    unsigned int origin(unsigned int q){
+        unsigned int d = 0;
+        unsigned int j = q;
+        while(true){
+            if(stamp[j]==time){
+                d += dist[j];
+                break;
+            }
+            unsigned int a = parent[j];
+            if(a==BK_ROOT){
+                stamp[j] = time;
+                dist[j] = 0;
+                break;
+            }
+            if(a==BK_NONE){
+                return BK_NONE;
+            }
+            d++;
+            j = graph.heads[a];
+        }
+        // remember the distances along the chain for the next orphans
+        unsigned int k = d;
+        for(j=q;stamp[j]!=time;j=graph.heads[parent[j]]){
+            stamp[j] = time;
+            dist[j] = k;
+            k--;
+        }
+        return d;
+    }
+    void adopt(){
+        while(!orphans.empty()){
+            unsigned int o = orphans.front();
+            orphans.pop_front();
+            unsigned char t = tree[o];
+            unsigned int best = BK_NONE;
+            unsigned int bestDist = BK_NONE;
+            for(unsigned int a=graph.begin(o);a<graph.end(o);a++){
+                unsigned int q = graph.heads[a];
+                node(q);
+                // q -> o must have capacity in the tree direction
+                if(tree[q]!=t || treeResidual(t, graph.twins[a])<=0){
+                    continue;
+                }
+                unsigned int d = origin(q);
+                if(d!=BK_NONE && d<bestDist){
+                    best = a;
+                    bestDist = d;
+                }
+            }
+            if(best!=BK_NONE){
+                parent[o] = best;
+                stamp[o] = time;
+                dist[o] = bestDist+1;
+                continue;
+            }
+            // no valid parent: o leaves the tree, its children become orphans and the
+            // neighbours that could reach it again are reactivated
+            tree[o] = FREE;
+            for(unsigned int a=graph.begin(o);a<graph.end(o);a++){
+                unsigned int q = graph.heads[a];
+                node(q);
+                if(tree[q]!=t){
+                    continue;
+                }
+                if(treeResidual(t, graph.twins[a])>0){
+                    setActive(q);
+                }
+                if(parent[q]!=BK_NONE && parent[q]!=BK_ROOT && graph.heads[parent[q]]==o){
+                    parent[q] = BK_NONE;
+                    orphans.push_back(q);
+                }
+            }
+        }
+    }
+};
+typedef BasicBoykovKolmogorov<float> BoykovKolmogorov;
+#endif
@@ -0,0 +1,112 @@
+#include "meshdecomp.h"
+#include <iostream>
+#include <cstdlib>
+#include <sstream>
+using namespace std;
+
+// headless decomposition: meshdecomp <model> [-o output] [--dense|--floyd] [--solver ff|bk|pr|ppr|dinic] [--capacity float|int32|int64] [--scale s] [--threads n] [--report file.json] [--dimacs file.max] [--sweep d1,d2,...] [--expansion] [--patches k|auto] [--max-patches k] [--seeds pair|sweep]
+int main(int argc, char* argv[])
+{
+    string input;
+    string output;
+    DecompositionOptions options;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg=="--dense"){
+            options.distanceMode = DENSE_DIJKSTRA;
+        }else if(arg=="--floyd"){
+            options.distanceMode = DENSE_FLOYD;
+        }else if(arg=="--solver" && i+1<argc){
+            string solver = argv[++i];
+            options.solverGiven = true;
+            if(solver=="ff"){
+                options.flowSolver = FORD_FULKERSON;
+            }else if(solver=="bk"){
+                options.flowSolver = BOYKOV_KOLMOGOROV;
+            }else if(solver=="pr"){
+                options.flowSolver = PUSH_RELABEL;
+            }else if(solver=="ppr"){
+                options.flowSolver = PARALLEL_PUSH_RELABEL;
+            }else if(solver=="dinic"){
+                options.flowSolver = DINIC;
+            }else{
+                input.clear();
+                break;
+            }
+        }else if(arg=="--capacity" && i+1<argc){
+            string capacity = argv[++i];
+            options.capacityGiven = true;
+            if(capacity=="float"){
+                options.capacityMode = FLOAT_CAPACITY;
+            }else if(capacity=="int32"){
+                options.capacityMode = INT32_CAPACITY;
+            }else if(capacity=="int64"){
+                options.capacityMode = INT64_CAPACITY;
+            }else{
+                input.clear();
+                break;
+            }
+        }else if(arg=="--scale" && i+1<argc){
+            options.capacityScale = atof(argv[++i]);
+            if(options.capacityScale<=0){
+                input.clear();
+                break;
+            }
+        }else if(arg=="--threads" && i+1<argc){
+            options.threads = atoi(argv[++i]);
+        }else if(arg=="--report" && i+1<argc){
+            options.report = argv[++i];
+        }else if(arg=="--sweep" && i+1<argc){
+            stringstream deltas(argv[++i]);
+            string delta;
+            while(getline(deltas, delta, ',')){
+                options.sweep.push_back(atof(delta.c_str()));
+            }
+        }else if(arg=="--expansion"){
+            options.expansion = true;
+        }else if(arg=="--patches" && i+1<argc){
+            string patches = argv[++i];
+            options.patches = patches=="auto" ? 0 : atoi(patches.c_str());
+            if(patches!="auto" && options.patches<2){
+                input.clear();
+                break;
+            }
+        }else if(arg=="--seeds" && i+1<argc){
+            string seeds = argv[++i];
+            if(seeds=="pair"){
+                options.seedMode = FARTHEST_PAIR;
+            }else if(seeds=="sweep"){
+                options.seedMode = DOUBLE_SWEEP;
+            }else{
+                input.clear();
+                break;
+            }
+        }else if(arg=="--max-patches" && i+1<argc){
+            options.maxPatches = atoi(argv[++i]);
+            if(options.maxPatches<2){
+                input.clear();
+                break;
+            }
+        }else if(arg=="--dimacs" && i+1<argc){
+            options.dimacs = argv[++i];
+        }else if(arg=="-o" && i+1<argc){
+            output = argv[++i];
+        }else if(input.empty() && arg[0]!='-'){
+            input = arg;
+        }else{
+            input.clear();
+            break;
+        }
+    }
+    if(input.empty()){
+        cout<<"usage: "<<argv[0]<<" <model> [-o output] [--dense|--floyd] [--solver ff|bk|pr|ppr|dinic] [--capacity float|int32|int64] [--scale s] [--threads n] [--report file.json] [--dimacs file.max] [--sweep d1,d2,...] [--expansion] [--patches k|auto] [--max-patches k] [--seeds pair|sweep]"<<endl;
+        return 2;
+    }
+    if(output.empty()){
+        output = input+"decompositionfuzzy.obj";
+    }
+    if(!decomposeFile(input, output, options)){
+        return 1;
+    }
+    return 0;
+}
@@ -3,7 +3,48 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <iostream>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <limits>
+#include "threadpool.h"
+#include "matrix.h"
+#include "edgekernels.h"
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DECOMPOSITION_X86_SIMD
+#include <immintrin.h>
+#endif
 using namespace std;
+// how the face-to-face distances are obtained
+enum DistanceMode{
+    DENSE_FLOYD,    // full N*N matrix with floyd, O(N^3), reference only
+    DENSE_DIJKSTRA, // full N*N matrix with one dijkstra per face in parallel, O(N^2 log N)
+    SPARSE_DIJKSTRA // single source rows computed on demand, O(N log N) each
+};
+// sparse graph of arbitrary degree read out of a distance matrix, it has the same
+// accessors as DualGraph so dijkstra runs on either
+struct Adjacency{
+    vector<vector<pair<unsigned int, float>>> rows;
+    Adjacency(unsigned int vn){
+        rows.resize(vn);
+    }
+    unsigned int size() const{
+        return rows.size();
+    }
+    unsigned int degree(unsigned int v) const{
+        return rows[v].size();
+    }
+    unsigned int neighbour(unsigned int v, unsigned int k) const{
+        return rows[v][k].first;
+    }
+    float weight(unsigned int v, unsigned int k) const{
+        return rows[v][k].second;
+    }
+};
+// tile edge of the blocked floyd, three 64x64 float tiles stay in L2
+#define FLOYD_TILE 64
+// c = min(c, a+b) over one tile, pc records the k giving the new minimum
+typedef void (*MinPlusKernel)(float* c, int* pc, const float* a, const float* b, unsigned int kbase, unsigned int stride);
 class Decomposition{
 public:
     float etaConvex = 1.0;
@@ -53,7 +94,158 @@ public:
         float cost = cost_1*cost_2-sqrt(1-cost_1*cost_1)*sqrt(1-cost_2*cost_2);
         return sqrt(a*a+b*b-2*a*b*cost);
     }
-    void floyd(float** distance, int** paths, unsigned int vn){
+    // calcAngDistance (face normal version) and calcGeoDistance for every edge of the
+    // batch, simd kernel picked from the cpu and blocks of edges spread over the pool
+    void calcDistances(const EdgeBatch& batch, float* ang, float* geo){
+        static EdgeKernel kernel = EdgeKernels::select();
+        float convex = etaConvex;
+        float concave = etaConcave;
+        ThreadPool::global().parallelFor(0, batch.size(), 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+            kernel(batch, begin, end, convex, concave, ang, geo);
+        });
+    }
+    void floyd(Matrix<float>& distance, Matrix<int>& paths){
+        // exact floyd, blocked into tiles so it runs from cache instead of walking the
+        // rows column wise; -1 becomes +inf inside the kernel and the size is padded
+        // to whole tiles
+        const float inf = numeric_limits<float>::infinity();
+        unsigned int vn = distance.rows();
+        unsigned int stride = (vn+FLOYD_TILE-1)/FLOYD_TILE*FLOYD_TILE;
+        Matrix<float> d(stride, stride, true);
+        Matrix<int> p(stride, stride, true);
+        d.fill(inf);
+        p.fill(0);
+        for(unsigned int i=0;i<vn;i++){
+            for(unsigned int j=0;j<vn;j++){
+                if(distance[i][j]!=-1){
+                    d[i][j] = distance[i][j];
+                }
+                p[i][j] = paths[i][j];
+            }
+        }
+        floydBlocked(d.data(), p.data(), d.stride());
+        for(unsigned int i=0;i<vn;i++){
+            for(unsigned int j=0;j<vn;j++){
+                distance[i][j] = d[i][j]==inf ? -1 : d[i][j];
+                paths[i][j] = p[i][j];
+            }
+        }
+    }
+    void floydBlocked(float* d, int* p, unsigned int stride){
+        // d and p are stride*stride with 64 byte aligned rows, stride a multiple of the tile
+        // three phases per diagonal tile: the tile itself, then its row and column,
+        // then every other tile; tiles inside phase two and three are independent
+        MinPlusKernel kernel = minPlusKernel();
+        unsigned int nb = stride/FLOYD_TILE;
+        ThreadPool& pool = ThreadPool::global();
+        for(unsigned int kb=0;kb<nb;kb++){
+            unsigned int kbase = kb*FLOYD_TILE;
+            float* dkk = tile(d, kb, kb, stride);
+            kernel(dkk, tile(p, kb, kb, stride), dkk, dkk, kbase, stride);
+            pool.parallelFor(0, 2*nb, 1, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int t=begin;t<end;t++){
+                    unsigned int o = t%nb;
+                    if(o==kb){
+                        continue;
+                    }
+                    if(t<nb){
+                        float* c = tile(d, kb, o, stride);
+                        kernel(c, tile(p, kb, o, stride), dkk, c, kbase, stride);
+                    }else{
+                        float* c = tile(d, o, kb, stride);
+                        kernel(c, tile(p, o, kb, stride), c, dkk, kbase, stride);
+                    }
+                }
+            });
+            pool.parallelFor(0, nb*nb, 1, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int t=begin;t<end;t++){
+                    unsigned int ib = t/nb;
+                    unsigned int jb = t%nb;
+                    if(ib==kb || jb==kb){
+                        continue;
+                    }
+                    kernel(tile(d, ib, jb, stride), tile(p, ib, jb, stride), tile(d, ib, kb, stride), tile(d, kb, jb, stride), kbase, stride);
+                }
+            });
+        }
+    }
+    template<typename T>
+    static T* tile(T* m, unsigned int ib, unsigned int jb, unsigned int stride){
+        return m+(size_t)ib*FLOYD_TILE*stride+(size_t)jb*FLOYD_TILE;
+    }
+    static void minPlusScalar(float* c, int* pc, const float* a, const float* b, unsigned int kbase, unsigned int stride){
+        for(unsigned int k=0;k<FLOYD_TILE;k++){
+            const float* bk = b+(size_t)k*stride;
+            for(unsigned int i=0;i<FLOYD_TILE;i++){
+                float aik = a[(size_t)i*stride+k];
+                float* ci = c+(size_t)i*stride;
+                int* pci = pc+(size_t)i*stride;
+                for(unsigned int j=0;j<FLOYD_TILE;j++){
+                    float temp = aik+bk[j];
+                    if(temp<ci[j]){
+                        ci[j] = temp;
+                        pci[j] = kbase+k;
+                    }
+                }
+            }
+        }
+    }
+#ifdef DECOMPOSITION_X86_SIMD
+    __attribute__((target("avx2")))
+    static void minPlusAVX2(float* c, int* pc, const float* a, const float* b, unsigned int kbase, unsigned int stride){
+        for(unsigned int k=0;k<FLOYD_TILE;k++){
+            const float* bk = b+(size_t)k*stride;
+            __m256i kv = _mm256_set1_epi32(kbase+k);
+            for(unsigned int i=0;i<FLOYD_TILE;i++){
+                __m256 aik = _mm256_set1_ps(a[(size_t)i*stride+k]);
+                float* ci = c+(size_t)i*stride;
+                int* pci = pc+(size_t)i*stride;
+                for(unsigned int j=0;j<FLOYD_TILE;j+=8){
+                    __m256 temp = _mm256_add_ps(aik, _mm256_load_ps(bk+j));
+                    __m256 cur = _mm256_load_ps(ci+j);
+                    __m256 less = _mm256_cmp_ps(temp, cur, _CMP_LT_OQ);
+                    _mm256_store_ps(ci+j, _mm256_blendv_ps(cur, temp, less));
+                    __m256 path = _mm256_castsi256_ps(_mm256_load_si256((__m256i*)(pci+j)));
+                    path = _mm256_blendv_ps(path, _mm256_castsi256_ps(kv), less);
+                    _mm256_store_si256((__m256i*)(pci+j), _mm256_castps_si256(path));
+                }
+            }
+        }
+    }
+    __attribute__((target("avx512f")))
+    static void minPlusAVX512(float* c, int* pc, const float* a, const float* b, unsigned int kbase, unsigned int stride){
+        for(unsigned int k=0;k<FLOYD_TILE;k++){
+            const float* bk = b+(size_t)k*stride;
+            __m512i kv = _mm512_set1_epi32(kbase+k);
+            for(unsigned int i=0;i<FLOYD_TILE;i++){
+                __m512 aik = _mm512_set1_ps(a[(size_t)i*stride+k]);
+                float* ci = c+(size_t)i*stride;
+                int* pci = pc+(size_t)i*stride;
+                for(unsigned int j=0;j<FLOYD_TILE;j+=16){
+                    __m512 temp = _mm512_add_ps(aik, _mm512_load_ps(bk+j));
+                    __m512 cur = _mm512_load_ps(ci+j);
+                    __mmask16 less = _mm512_cmp_ps_mask(temp, cur, _CMP_LT_OQ);
+                    _mm512_mask_store_ps(ci+j, less, temp);
+                    _mm512_mask_store_epi32(pci+j, less, kv);
+                }
+            }
+        }
+    }
+#endif
+    static MinPlusKernel minPlusKernel(){
+#ifdef DECOMPOSITION_X86_SIMD
+        if(__builtin_cpu_supports("avx512f")){
+            return minPlusAVX512;
+        }
+        if(__builtin_cpu_supports("avx2")){
+            return minPlusAVX2;
+        }
+#endif
+        return minPlusScalar;
+    }
+    void floydReference(Matrix<float>& distance, Matrix<int>& paths){
+        unsigned int vn = distance.rows();
+        // the original triple loop, kept to check the blocked version against
         // due to the graph is undirected graph, thus the distance can be calculated for half of matrix
         for(unsigned int jn=0;jn<vn;jn++){
             for(unsigned int i=0;i<vn;i++){
@@ -71,6 +263,76 @@ public:
             }
         }
     }
+    void dijkstraAll(Matrix<float>& distance, Matrix<int>& paths){
+        unsigned int vn = distance.rows();
+        // same input/output as floyd, but every source is an independent dijkstra over
+        // the sparse graph, paths[i][j] becomes the face before j on the path from i
+        Adjacency graph(vn);
+        ThreadPool::global().parallelFor(0, vn, 64, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int i=begin;i<end;i++){
+                for(unsigned int j=0;j<vn;j++){
+                    if(j!=i && distance[i][j]!=-1){
+                        graph.rows[i].push_back(make_pair(j, distance[i][j]));
+                    }
+                }
+            }
+        });
+        // the rows are only written after the whole graph is extracted
+        dijkstraAll(graph, distance, paths);
+    }
+    template<typename Graph>
+    void dijkstraAll(const Graph& graph, Matrix<float>& distance, Matrix<int>& paths){
+        ThreadPool::global().parallelFor(0, graph.size(), 16, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int i=begin;i<end;i++){
+                dijkstra(graph, i, distance[i], paths[i]);
+            }
+        });
+    }
+    template<typename Graph>
+    void dijkstra(const Graph& graph, unsigned int src, float* distance, int* parent=NULL){
+        // single source shortest path on the dual graph, -1 means unreachable like floyd
+        unsigned int vn = graph.size();
+        for(unsigned int i=0;i<vn;i++){
+            distance[i] = -1;
+        }
+        if(parent){
+            for(unsigned int i=0;i<vn;i++){
+                parent[i] = i;
+            }
+        }
+        typedef pair<float, unsigned int> QItem;
+        priority_queue<QItem, vector<QItem>, greater<QItem>> Q;
+        distance[src] = 0;
+        Q.push(QItem(0, src));
+        while(Q.size()>0){
+            QItem top = Q.top();
+            Q.pop();
+            unsigned int cur = top.second;
+            if(top.first>distance[cur]){
+                continue;
+            }
+            for(unsigned int i=0;i<graph.degree(cur);i++){
+                unsigned int v = graph.neighbour(cur, i);
+                float temp = top.first+graph.weight(cur, i);
+                if(distance[v]==-1||temp<distance[v]){
+                    distance[v] = temp;
+                    if(parent){
+                        parent[v] = cur;
+                    }
+                    Q.push(QItem(temp, v));
+                }
+            }
+        }
+    }
+    unsigned int farthest(const float* distance, unsigned int vn){
+        unsigned int maxi = 0;
+        for(unsigned int i=1;i<vn;i++){
+            if(distance[i]>distance[maxi]){
+                maxi = i;
+            }
+        }
+        return maxi;
+    }
 };
 
 #endif
@@ -0,0 +1,120 @@
+#ifndef DIMACS_H
+#define DIMACS_H
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include "flowgraph.h"
+using namespace std;
+// DIMACS max-flow files: "p max n m", "n id s", "n id t", "a u v cap" with 1 based
+// nodes, "c" lines are comments. The capacities are written as they are, floats for
+// the fuzzy graph, so exact integer instances need --capacity int32/int64
+template<typename Cap>
+bool saveDimacs(const string& path, const BasicFlowGraph<Cap>& graph, unsigned int s, unsigned int d, const vector<string>& comments=vector<string>()){
+    ofstream out(path);
+    if(!out){
+        return false;
+    }
+    unsigned int n = graph.size();
+    unsigned int m = 0;
+    for(unsigned int a=0;a<graph.arcCount();a++){
+        if(graph.capacity[a]>0){
+            m++;
+        }
+    }
+    out.precision(9);
+    for(unsigned int i=0;i<comments.size();i++){
+        out<<"c "<<comments[i]<<"\n";
+    }
+    out<<"p max "<<n<<" "<<m<<"\n";
+    out<<"n "<<s+1<<" s\n";
+    out<<"n "<<d+1<<" t\n";
+    for(unsigned int v=0;v<n;v++){
+        for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+            if(graph.capacity[a]>0){
+                out<<"a "<<v+1<<" "<<graph.heads[a]+1<<" "<<graph.capacity[a]<<"\n";
+            }
+        }
+    }
+    return (bool)out;
+}
+// the arcs u->v and v->u of a file become one FlowEdge, parallel arcs are summed;
+// returns false if the file is missing, malformed or has no source or sink
+inline bool loadDimacs(const string& path, unsigned int& n, vector<FlowEdge>& edges, unsigned int& s, unsigned int& d){
+    ifstream in(path);
+    if(!in){
+        return false;
+    }
+    n = 0;
+    s = 0;
+    d = 0;
+    edges.clear();
+    bool hasSource = false;
+    bool hasSink = false;
+    // unordered node pair to its edge
+    map<pair<unsigned int, unsigned int>, unsigned int> pairs;
+    string line;
+    while(getline(in, line)){
+        if(line.empty() || line[0]=='c'){
+            continue;
+        }
+        stringstream fields(line);
+        string kind;
+        fields>>kind;
+        if(kind=="p"){
+            string problem;
+            unsigned int arcs;
+            if(!(fields>>problem>>n>>arcs) || problem!="max"){
+                return false;
+            }
+        }else if(kind=="n"){
+            unsigned int id;
+            string which;
+            if(!(fields>>id>>which) || id<1 || id>n){
+                return false;
+            }
+            if(which=="s"){
+                s = id-1;
+                hasSource = true;
+            }else if(which=="t"){
+                d = id-1;
+                hasSink = true;
+            }else{
+                return false;
+            }
+        }else if(kind=="a"){
+            unsigned int u, v;
+            float cap;
+            if(!(fields>>u>>v>>cap) || u<1 || v<1 || u>n || v>n){
+                return false;
+            }
+            u--;
+            v--;
+            if(u==v){
+                continue;
+            }
+            pair<unsigned int, unsigned int> key(min(u, v), max(u, v));
+            map<pair<unsigned int, unsigned int>, unsigned int>::iterator it = pairs.find(key);
+            if(it==pairs.end()){
+                FlowEdge e;
+                e.u = key.first;
+                e.v = key.second;
+                e.cap = 0;
+                e.rcap = 0;
+                it = pairs.insert(make_pair(key, (unsigned int)edges.size())).first;
+                edges.push_back(e);
+            }
+            FlowEdge& e = edges[it->second];
+            if(u==e.u){
+                e.cap += cap;
+            }else{
+                e.rcap += cap;
+            }
+        }else{
+            return false;
+        }
+    }
+    return n>0 && hasSource && hasSink && s!=d;
+}
+#endif
@@ -0,0 +1,155 @@
+#ifndef DINIC_H
+#define DINIC_H
+#include <vector>
+#include <queue>
+#include <limits>
+#include "flowgraph.h"
+using namespace std;
+// level of nodes not reached by the bfs, or pruned as dead ends
+#define DINIC_UNSET 0xffffffffu
+// dinic max flow: a bfs level graph per phase and blocking flows along it with current
+// arc pointers, so the nodes are reset once per phase instead of once per path
+template<typename Cap>
+class BasicDinic{
+public:
+    BasicFlowGraph<Cap> graph;
+    // augmenting paths found by the last ff
+    unsigned int augmentations;
+    unsigned int phases;
+    // capacity scaling, integer capacities only: the phases first use just the arcs
+    // with a residual of at least delta, halving delta down to 1
+    bool scaling;
+
+    BasicDinic(){
+        augmentations = 0;
+        scaling = false;
+    }
+    BasicDinic(const Matrix<float>& distance){
+        graph.build(distance);
+        augmentations = 0;
+        scaling = false;
+    }
+    BasicDinic(unsigned int n, const vector<FlowEdge>& edges){
+        graph.build(n, edges);
+        augmentations = 0;
+        scaling = false;
+    }
+    void ff(int s, int d){
+        unsigned int n = graph.size();
+        graph.reset();
+        level.assign(n, DINIC_UNSET);
+        current.assign(n, 0);
+        augmentations = 0;
+        phases = 0;
+        delta = 0;
+        if(scaling && numeric_limits<Cap>::is_integer){
+            Cap largest = 0;
+            for(unsigned int a=0;a<graph.arcCount();a++){
+                largest = max(largest, graph.capacity[a]);
+            }
+            for(delta=1;delta<=largest/2;delta*=2){
+            }
+        }
+        while(true){
+            while(levels(s, d)){
+                phases++;
+                blockingFlow(s, d);
+            }
+            if(delta<=1){
+                break;
+            }
+            delta /= 2;
+        }
+    }
+    vector<int> cut(int s, int d){
+        return graph.sourceSide(s, d);
+    }
+private:
+    vector<unsigned int> level;
+    vector<unsigned int> current;
+    vector<unsigned int> path;
+    // smallest residual an arc needs to be used, 0 without scaling
+    Cap delta;
+
+    bool usable(unsigned int a) const{
+        return graph.residual[a]>0 && graph.residual[a]>=delta;
+    }
+
+    bool levels(unsigned int s, unsigned int d){
+        unsigned int n = graph.size();
+        for(unsigned int v=0;v<n;v++){
+            level[v] = DINIC_UNSET;
+            current[v] = graph.begin(v);
+        }
+        queue<unsigned int> Q;
+        Q.push(s);
+        level[s] = 0;
+        while(Q.size()>0){
+            unsigned int u = Q.front();
+            Q.pop();
+            // nodes beyond the sink level are never on a shortest path
+            if(u==d){
+                break;
+            }
+            for(unsigned int a=graph.begin(u);a<graph.end(u);a++){
+                unsigned int w = graph.heads[a];
+                if(level[w]==DINIC_UNSET && usable(a)){
+                    level[w] = level[u]+1;
+                    Q.push(w);
+                }
+            }
+        }
+        return level[d]!=DINIC_UNSET;
+    }
+    // iterative dfs, path holds the arcs from s to the current node
+    void blockingFlow(unsigned int s, unsigned int d){
+        vector<Cap>& residual = graph.residual;
+        path.clear();
+        unsigned int v = s;
+        while(true){
+            if(v==d){
+                Cap f = residual[path[0]];
+                for(unsigned int k=1;k<path.size();k++){
+                    f = min(f, residual[path[k]]);
+                }
+                unsigned int first = path.size();
+                for(unsigned int k=0;k<path.size();k++){
+                    residual[path[k]] -= f;
+                    residual[graph.twins[path[k]]] += f;
+                    if(!usable(path[k]) && first==path.size()){
+                        first = k;
+                    }
+                }
+                augmentations++;
+                // continue from the tail of the first saturated arc
+                path.resize(first);
+                v = first==0 ? s : graph.heads[path[first-1]];
+                continue;
+            }
+            while(current[v]<graph.end(v)){
+                unsigned int a = current[v];
+                unsigned int w = graph.heads[a];
+                if(usable(a) && level[w]==level[v]+1){
+                    break;
+                }
+                current[v]++;
+            }
+            if(current[v]<graph.end(v)){
+                path.push_back(current[v]);
+                v = graph.heads[current[v]];
+                continue;
+            }
+            // dead end, drop it from the level graph and retreat
+            level[v] = DINIC_UNSET;
+            if(v==s){
+                break;
+            }
+            unsigned int a = path.back();
+            path.pop_back();
+            v = graph.heads[graph.twins[a]];
+            current[v]++;
+        }
+    }
+};
+typedef BasicDinic<float> Dinic;
+#endif
@@ -0,0 +1,144 @@
+#ifndef DUALBUILDER_H
+#define DUALBUILDER_H
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include "dualgraph.h"
+#include "threadpool.h"
+using namespace std;
+// one record per face corner: the edge as (min vertex, max vertex), the face that owns
+// it and the vertex opposite to it; side is face<<1 | 1 when begin<end in the face order
+struct HalfEdge{
+    uint64_t key;
+    unsigned int side;
+    unsigned int opposite;
+};
+// edges which do not join exactly two faces
+struct DualReport{
+    // only one face, (begin, end)
+    vector<pair<unsigned int, unsigned int>> boundary;
+    // three or more faces, only the first two are joined
+    vector<pair<unsigned int, unsigned int>> nonManifold;
+    // both faces walk the edge in the same direction
+    unsigned int flipped;
+    DualReport(){
+        flipped = 0;
+    }
+};
+// builds the dual graph from a triangle index list: half edges are emitted in
+// parallel, radix sorted by edge key and paired in one linear pass
+class DualBuilder{
+public:
+    vector<HalfEdge> records;
+    vector<HalfEdge> buffer;
+
+    void build(const vector<unsigned int>& indices, DualGraph& dual, DualReport& report){
+        unsigned int faceN = indices.size()/3;
+        dual.reset(faceN);
+        report = DualReport();
+        emit(indices);
+        radixSort();
+        pairUp(dual, report);
+    }
+private:
+    void emit(const vector<unsigned int>& indices){
+        unsigned int faceN = indices.size()/3;
+        records.resize(faceN*3);
+        ThreadPool::global().parallelFor(0, faceN, 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int i=begin;i<end;i++){
+                for(unsigned int j=0;j<3;j++){
+                    unsigned int a = indices[i*3+j];
+                    unsigned int b = indices[i*3+(j+1)%3];
+                    HalfEdge& h = records[i*3+j];
+                    if(a<b){
+                        h.key = (uint64_t)a<<32|b;
+                        h.side = i<<1|1;
+                    }else{
+                        h.key = (uint64_t)b<<32|a;
+                        h.side = i<<1;
+                    }
+                    h.opposite = indices[i*3+(j+2)%3];
+                }
+            }
+        });
+    }
+    // stable lsd radix sort on the key, 8 bits per pass, passes where every key has
+    // the same digit are skipped (the high bits of small vertex ids)
+    void radixSort(){
+        size_t n = records.size();
+        ThreadPool& pool = ThreadPool::global();
+        unsigned int parts = pool.size();
+        size_t chunk = (n+parts-1)/parts;
+        if(chunk==0){
+            return;
+        }
+        buffer.resize(n);
+        vector<size_t> counts((size_t)parts*256);
+        for(unsigned int shift=0;shift<64;shift+=8){
+            fill(counts.begin(), counts.end(), 0);
+            pool.parallelFor(0, parts, 1, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int p=begin;p<end;p++){
+                    size_t* count = &counts[(size_t)p*256];
+                    for(size_t i=p*chunk;i<n && i<(p+1)*chunk;i++){
+                        count[(records[i].key>>shift)&0xff]++;
+                    }
+                }
+            });
+            // exclusive offsets, digit major then part so equal digits keep their order
+            size_t offset = 0;
+            bool single = false;
+            for(unsigned int d=0;d<256;d++){
+                size_t digitStart = offset;
+                for(unsigned int p=0;p<parts;p++){
+                    size_t c = counts[(size_t)p*256+d];
+                    counts[(size_t)p*256+d] = offset;
+                    offset += c;
+                }
+                if(offset-digitStart==n){
+                    single = true;
+                }
+            }
+            if(single){
+                continue;
+            }
+            pool.parallelFor(0, parts, 1, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int p=begin;p<end;p++){
+                    size_t* next = &counts[(size_t)p*256];
+                    for(size_t i=p*chunk;i<n && i<(p+1)*chunk;i++){
+                        buffer[next[(records[i].key>>shift)&0xff]++] = records[i];
+                    }
+                }
+            });
+            records.swap(buffer);
+        }
+    }
+    void pairUp(DualGraph& dual, DualReport& report){
+        size_t n = records.size();
+        size_t i = 0;
+        while(i<n){
+            size_t j = i+1;
+            while(j<n && records[j].key==records[i].key){
+                j++;
+            }
+            unsigned int begin = records[i].key>>32;
+            unsigned int end = records[i].key&0xffffffff;
+            if(j-i==1){
+                report.boundary.push_back(make_pair(begin, end));
+            }else{
+                if(j-i>2){
+                    report.nonManifold.push_back(make_pair(begin, end));
+                }
+                const HalfEdge* l = &records[i];
+                const HalfEdge* r = &records[i+1];
+                if((l->side&1)==(r->side&1)){
+                    report.flipped++;
+                }else if((l->side&1)==0){
+                    swap(l, r);
+                }
+                dual.addEdge(begin, end, l->side>>1, r->side>>1, l->opposite, r->opposite);
+            }
+            i = j;
+        }
+    }
+};
+#endif
@@ -0,0 +1,102 @@
+#ifndef DUALGRAPH_H
+#define DUALGRAPH_H
+#include <vector>
+using namespace std;
+// neighbour slots per face, a triangle shares at most three edges
+#define DUAL_SLOTS 3
+// face adjacency of a triangle mesh: three neighbour slots per face that point into
+// per-edge attribute arrays, O(N) memory instead of the N*N face pair matrices
+class DualGraph{
+public:
+    // per face, DUAL_SLOTS entries each, filled from slot 0
+    vector<int> neighbours;
+    vector<int> edgeOf;
+    vector<unsigned char> degrees;
+    // per edge: the two faces, the shared vertices and the vertices opposite to the edge
+    vector<unsigned int> left;
+    vector<unsigned int> right;
+    vector<unsigned int> begin;
+    vector<unsigned int> end;
+    vector<unsigned int> leftv;
+    vector<unsigned int> rightv;
+    // per edge: dihedral term, geodesic term and the combined dual edge weight
+    vector<float> angDistance;
+    vector<float> geoDistance;
+    vector<float> weights;
+    // edges dropped because a face already had all of its slots taken (non-manifold)
+    unsigned int overflow;
+
+    DualGraph(){
+        overflow = 0;
+    }
+    void reset(unsigned int faceN){
+        neighbours.assign(faceN*DUAL_SLOTS, -1);
+        edgeOf.assign(faceN*DUAL_SLOTS, -1);
+        degrees.assign(faceN, 0);
+        left.clear();
+        right.clear();
+        begin.clear();
+        end.clear();
+        leftv.clear();
+        rightv.clear();
+        angDistance.clear();
+        geoDistance.clear();
+        weights.clear();
+        overflow = 0;
+    }
+    // returns the edge index, or -1 if either face has no free slot
+    int addEdge(unsigned int b, unsigned int e, unsigned int l, unsigned int r, unsigned int lv, unsigned int rv){
+        if(degrees[l]>=DUAL_SLOTS || degrees[r]>=DUAL_SLOTS){
+            overflow++;
+            return -1;
+        }
+        int id = left.size();
+        left.push_back(l);
+        right.push_back(r);
+        begin.push_back(b);
+        end.push_back(e);
+        leftv.push_back(lv);
+        rightv.push_back(rv);
+        angDistance.push_back(0);
+        geoDistance.push_back(0);
+        weights.push_back(0);
+        link(l, r, id);
+        link(r, l, id);
+        return id;
+    }
+    unsigned int size() const{
+        return degrees.size();
+    }
+    unsigned int edgeCount() const{
+        return left.size();
+    }
+    unsigned int degree(unsigned int face) const{
+        return degrees[face];
+    }
+    unsigned int neighbour(unsigned int face, unsigned int slot) const{
+        return neighbours[face*DUAL_SLOTS+slot];
+    }
+    unsigned int edge(unsigned int face, unsigned int slot) const{
+        return edgeOf[face*DUAL_SLOTS+slot];
+    }
+    float weight(unsigned int face, unsigned int slot) const{
+        return weights[edgeOf[face*DUAL_SLOTS+slot]];
+    }
+    // edge between two faces or -1, at most DUAL_SLOTS probes
+    int findEdge(unsigned int a, unsigned int b) const{
+        for(unsigned int k=0;k<degrees[a];k++){
+            if(neighbours[a*DUAL_SLOTS+k]==(int)b){
+                return edgeOf[a*DUAL_SLOTS+k];
+            }
+        }
+        return -1;
+    }
+private:
+    void link(unsigned int from, unsigned int to, int id){
+        unsigned int slot = from*DUAL_SLOTS+degrees[from];
+        neighbours[slot] = to;
+        edgeOf[slot] = id;
+        degrees[from]++;
+    }
+};
+#endif
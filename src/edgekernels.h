@@ -0,0 +1,223 @@
+#ifndef EDGEKERNELS_H
+#define EDGEKERNELS_H
+#include <vector>
+#include <cmath>
+#include <cstddef>
+#include <glm/glm.hpp>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define EDGEKERNELS_X86_SIMD
+#include <immintrin.h>
+#endif
+using namespace std;
+// structure of arrays input of the batched distance kernels, one entry per dual edge:
+// the shared edge begin->end, the opposite vertex of the left (a) and right (b) face
+// and the two face normals
+struct EdgeBatch{
+    vector<float> bx, by, bz;
+    vector<float> ex, ey, ez;
+    vector<float> ax, ay, az;
+    vector<float> cx, cy, cz;
+    vector<float> anx, any, anz;
+    vector<float> bnx, bny, bnz;
+    void resize(size_t n){
+        vector<float>* all[18] = {&bx, &by, &bz, &ex, &ey, &ez, &ax, &ay, &az, &cx, &cy, &cz, &anx, &any, &anz, &bnx, &bny, &bnz};
+        for(unsigned int k=0;k<18;k++){
+            all[k]->resize(n);
+        }
+    }
+    size_t size() const{
+        return bx.size();
+    }
+    void set(size_t i, glm::vec3 begin, glm::vec3 end, glm::vec3 a1, glm::vec3 b1, glm::vec3 an, glm::vec3 bn){
+        bx[i] = begin.x; by[i] = begin.y; bz[i] = begin.z;
+        ex[i] = end.x; ey[i] = end.y; ez[i] = end.z;
+        ax[i] = a1.x; ay[i] = a1.y; az[i] = a1.z;
+        cx[i] = b1.x; cy[i] = b1.y; cz[i] = b1.z;
+        anx[i] = an.x; any[i] = an.y; anz[i] = an.z;
+        bnx[i] = bn.x; bny[i] = bn.y; bnz[i] = bn.z;
+    }
+};
+// ang and geo for edges [begin,end) of the batch
+typedef void (*EdgeKernel)(const EdgeBatch& in, size_t begin, size_t end, float etaConvex, float etaConcave, float* ang, float* geo);
+// the same formulas as Decomposition::calcAngDistance/calcGeoDistance, evaluated in the
+// same order, one version per instruction set
+class EdgeKernels{
+public:
+    static void scalar(const EdgeBatch& in, size_t begin, size_t end, float etaConvex, float etaConcave, float* ang, float* geo){
+        for(size_t i=begin;i<end;i++){
+            // convex if the opposite vertices lie behind the normals
+            float sx = in.ax[i]+in.cx[i]-(in.bx[i]+in.ex[i]);
+            float sy = in.ay[i]+in.cy[i]-(in.by[i]+in.ey[i]);
+            float sz = in.az[i]+in.cz[i]-(in.bz[i]+in.ez[i]);
+            float convex = sx*(in.anx[i]+in.bnx[i])+sy*(in.any[i]+in.bny[i])+sz*(in.anz[i]+in.bnz[i]);
+            float eta = convex<0 ? etaConvex : etaConcave;
+            ang[i] = eta*(1-(in.anx[i]*in.bnx[i]+in.any[i]*in.bny[i]+in.anz[i]*in.bnz[i]));
+            // centers of the triangles relative to begin
+            float px = (in.bx[i]+in.ex[i]+in.ax[i])/3-in.bx[i];
+            float py = (in.by[i]+in.ey[i]+in.ay[i])/3-in.by[i];
+            float pz = (in.bz[i]+in.ez[i]+in.az[i])/3-in.bz[i];
+            float qx = (in.bx[i]+in.ex[i]+in.cx[i])/3-in.bx[i];
+            float qy = (in.by[i]+in.ey[i]+in.cy[i])/3-in.by[i];
+            float qz = (in.bz[i]+in.ez[i]+in.cz[i])/3-in.bz[i];
+            float dx = in.ex[i]-in.bx[i];
+            float dy = in.ey[i]-in.by[i];
+            float dz = in.ez[i]-in.bz[i];
+            float a = sqrt(px*px+py*py+pz*pz);
+            float b = sqrt(qx*qx+qy*qy+qz*qz);
+            float invc = 1/sqrt(dx*dx+dy*dy+dz*dz);
+            float cost_1 = (px/a*dx+py/a*dy+pz/a*dz)*invc;
+            float cost_2 = (qx/b*dx+qy/b*dy+qz/b*dz)*invc;
+            float cost = cost_1*cost_2-sqrt(1-cost_1*cost_1)*sqrt(1-cost_2*cost_2);
+            geo[i] = sqrt(a*a+b*b-2*a*b*cost);
+        }
+    }
+#ifdef EDGEKERNELS_X86_SIMD
+    __attribute__((target("sse4.1")))
+    static void sse4(const EdgeBatch& in, size_t begin, size_t end, float etaConvex, float etaConcave, float* ang, float* geo){
+        size_t i = begin;
+        const __m128 one = _mm_set1_ps(1);
+        const __m128 two = _mm_set1_ps(2);
+        const __m128 three = _mm_set1_ps(3);
+        const __m128 vconvex = _mm_set1_ps(etaConvex);
+        const __m128 vconcave = _mm_set1_ps(etaConcave);
+        for(;i+4<=end;i+=4){
+            __m128 bx = _mm_loadu_ps(&in.bx[i]), by = _mm_loadu_ps(&in.by[i]), bz = _mm_loadu_ps(&in.bz[i]);
+            __m128 ex = _mm_loadu_ps(&in.ex[i]), ey = _mm_loadu_ps(&in.ey[i]), ez = _mm_loadu_ps(&in.ez[i]);
+            __m128 ax = _mm_loadu_ps(&in.ax[i]), ay = _mm_loadu_ps(&in.ay[i]), az = _mm_loadu_ps(&in.az[i]);
+            __m128 cx = _mm_loadu_ps(&in.cx[i]), cy = _mm_loadu_ps(&in.cy[i]), cz = _mm_loadu_ps(&in.cz[i]);
+            __m128 anx = _mm_loadu_ps(&in.anx[i]), any = _mm_loadu_ps(&in.any[i]), anz = _mm_loadu_ps(&in.anz[i]);
+            __m128 bnx = _mm_loadu_ps(&in.bnx[i]), bny = _mm_loadu_ps(&in.bny[i]), bnz = _mm_loadu_ps(&in.bnz[i]);
+            __m128 sx = _mm_sub_ps(_mm_add_ps(ax, cx), _mm_add_ps(bx, ex));
+            __m128 sy = _mm_sub_ps(_mm_add_ps(ay, cy), _mm_add_ps(by, ey));
+            __m128 sz = _mm_sub_ps(_mm_add_ps(az, cz), _mm_add_ps(bz, ez));
+            __m128 convex = _mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, _mm_add_ps(anx, bnx)), _mm_mul_ps(sy, _mm_add_ps(any, bny))), _mm_mul_ps(sz, _mm_add_ps(anz, bnz)));
+            __m128 eta = _mm_blendv_ps(vconcave, vconvex, _mm_cmplt_ps(convex, _mm_setzero_ps()));
+            __m128 dn = _mm_add_ps(_mm_add_ps(_mm_mul_ps(anx, bnx), _mm_mul_ps(any, bny)), _mm_mul_ps(anz, bnz));
+            _mm_storeu_ps(ang+i, _mm_mul_ps(eta, _mm_sub_ps(one, dn)));
+            __m128 px = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(bx, ex), ax), three), bx);
+            __m128 py = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(by, ey), ay), three), by);
+            __m128 pz = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(bz, ez), az), three), bz);
+            __m128 qx = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(bx, ex), cx), three), bx);
+            __m128 qy = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(by, ey), cy), three), by);
+            __m128 qz = _mm_sub_ps(_mm_div_ps(_mm_add_ps(_mm_add_ps(bz, ez), cz), three), bz);
+            __m128 dx = _mm_sub_ps(ex, bx), dy = _mm_sub_ps(ey, by), dz = _mm_sub_ps(ez, bz);
+            __m128 a = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, px), _mm_mul_ps(py, py)), _mm_mul_ps(pz, pz)));
+            __m128 b = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, qx), _mm_mul_ps(qy, qy)), _mm_mul_ps(qz, qz)));
+            __m128 invc = _mm_div_ps(one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz))));
+            __m128 cost_1 = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(px, a), dx), _mm_mul_ps(_mm_div_ps(py, a), dy)), _mm_mul_ps(_mm_div_ps(pz, a), dz)), invc);
+            __m128 cost_2 = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_div_ps(qx, b), dx), _mm_mul_ps(_mm_div_ps(qy, b), dy)), _mm_mul_ps(_mm_div_ps(qz, b), dz)), invc);
+            __m128 sine = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(cost_1, cost_1))), _mm_sqrt_ps(_mm_sub_ps(one, _mm_mul_ps(cost_2, cost_2))));
+            __m128 cost = _mm_sub_ps(_mm_mul_ps(cost_1, cost_2), sine);
+            __m128 g = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(a, a), _mm_mul_ps(b, b)), _mm_mul_ps(_mm_mul_ps(_mm_mul_ps(two, a), b), cost));
+            _mm_storeu_ps(geo+i, _mm_sqrt_ps(g));
+        }
+        scalar(in, i, end, etaConvex, etaConcave, ang, geo);
+    }
+    __attribute__((target("avx2")))
+    static void avx2(const EdgeBatch& in, size_t begin, size_t end, float etaConvex, float etaConcave, float* ang, float* geo){
+        size_t i = begin;
+        const __m256 one = _mm256_set1_ps(1);
+        const __m256 two = _mm256_set1_ps(2);
+        const __m256 three = _mm256_set1_ps(3);
+        const __m256 vconvex = _mm256_set1_ps(etaConvex);
+        const __m256 vconcave = _mm256_set1_ps(etaConcave);
+        for(;i+8<=end;i+=8){
+            __m256 bx = _mm256_loadu_ps(&in.bx[i]), by = _mm256_loadu_ps(&in.by[i]), bz = _mm256_loadu_ps(&in.bz[i]);
+            __m256 ex = _mm256_loadu_ps(&in.ex[i]), ey = _mm256_loadu_ps(&in.ey[i]), ez = _mm256_loadu_ps(&in.ez[i]);
+            __m256 ax = _mm256_loadu_ps(&in.ax[i]), ay = _mm256_loadu_ps(&in.ay[i]), az = _mm256_loadu_ps(&in.az[i]);
+            __m256 cx = _mm256_loadu_ps(&in.cx[i]), cy = _mm256_loadu_ps(&in.cy[i]), cz = _mm256_loadu_ps(&in.cz[i]);
+            __m256 anx = _mm256_loadu_ps(&in.anx[i]), any = _mm256_loadu_ps(&in.any[i]), anz = _mm256_loadu_ps(&in.anz[i]);
+            __m256 bnx = _mm256_loadu_ps(&in.bnx[i]), bny = _mm256_loadu_ps(&in.bny[i]), bnz = _mm256_loadu_ps(&in.bnz[i]);
+            __m256 sx = _mm256_sub_ps(_mm256_add_ps(ax, cx), _mm256_add_ps(bx, ex));
+            __m256 sy = _mm256_sub_ps(_mm256_add_ps(ay, cy), _mm256_add_ps(by, ey));
+            __m256 sz = _mm256_sub_ps(_mm256_add_ps(az, cz), _mm256_add_ps(bz, ez));
+            __m256 convex = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, _mm256_add_ps(anx, bnx)), _mm256_mul_ps(sy, _mm256_add_ps(any, bny))), _mm256_mul_ps(sz, _mm256_add_ps(anz, bnz)));
+            __m256 eta = _mm256_blendv_ps(vconcave, vconvex, _mm256_cmp_ps(convex, _mm256_setzero_ps(), _CMP_LT_OQ));
+            __m256 dn = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(anx, bnx), _mm256_mul_ps(any, bny)), _mm256_mul_ps(anz, bnz));
+            _mm256_storeu_ps(ang+i, _mm256_mul_ps(eta, _mm256_sub_ps(one, dn)));
+            __m256 px = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(bx, ex), ax), three), bx);
+            __m256 py = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(by, ey), ay), three), by);
+            __m256 pz = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(bz, ez), az), three), bz);
+            __m256 qx = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(bx, ex), cx), three), bx);
+            __m256 qy = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(by, ey), cy), three), by);
+            __m256 qz = _mm256_sub_ps(_mm256_div_ps(_mm256_add_ps(_mm256_add_ps(bz, ez), cz), three), bz);
+            __m256 dx = _mm256_sub_ps(ex, bx), dy = _mm256_sub_ps(ey, by), dz = _mm256_sub_ps(ez, bz);
+            __m256 a = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px, px), _mm256_mul_ps(py, py)), _mm256_mul_ps(pz, pz)));
+            __m256 b = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(qx, qx), _mm256_mul_ps(qy, qy)), _mm256_mul_ps(qz, qz)));
+            __m256 invc = _mm256_div_ps(one, _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz))));
+            __m256 cost_1 = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(px, a), dx), _mm256_mul_ps(_mm256_div_ps(py, a), dy)), _mm256_mul_ps(_mm256_div_ps(pz, a), dz)), invc);
+            __m256 cost_2 = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_div_ps(qx, b), dx), _mm256_mul_ps(_mm256_div_ps(qy, b), dy)), _mm256_mul_ps(_mm256_div_ps(qz, b), dz)), invc);
+            __m256 sine = _mm256_mul_ps(_mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_mul_ps(cost_1, cost_1))), _mm256_sqrt_ps(_mm256_sub_ps(one, _mm256_mul_ps(cost_2, cost_2))));
+            __m256 cost = _mm256_sub_ps(_mm256_mul_ps(cost_1, cost_2), sine);
+            __m256 g = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(a, a), _mm256_mul_ps(b, b)), _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(two, a), b), cost));
+            _mm256_storeu_ps(geo+i, _mm256_sqrt_ps(g));
+        }
+        scalar(in, i, end, etaConvex, etaConcave, ang, geo);
+    }
+// gcc 12 warns about the undefined passthrough operand inside _mm512_sqrt_ps
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    __attribute__((target("avx512f")))
+    static void avx512(const EdgeBatch& in, size_t begin, size_t end, float etaConvex, float etaConcave, float* ang, float* geo){
+        size_t i = begin;
+        const __m512 one = _mm512_set1_ps(1);
+        const __m512 two = _mm512_set1_ps(2);
+        const __m512 three = _mm512_set1_ps(3);
+        const __m512 vconvex = _mm512_set1_ps(etaConvex);
+        const __m512 vconcave = _mm512_set1_ps(etaConcave);
+        for(;i+16<=end;i+=16){
+            __m512 bx = _mm512_loadu_ps(&in.bx[i]), by = _mm512_loadu_ps(&in.by[i]), bz = _mm512_loadu_ps(&in.bz[i]);
+            __m512 ex = _mm512_loadu_ps(&in.ex[i]), ey = _mm512_loadu_ps(&in.ey[i]), ez = _mm512_loadu_ps(&in.ez[i]);
+            __m512 ax = _mm512_loadu_ps(&in.ax[i]), ay = _mm512_loadu_ps(&in.ay[i]), az = _mm512_loadu_ps(&in.az[i]);
+            __m512 cx = _mm512_loadu_ps(&in.cx[i]), cy = _mm512_loadu_ps(&in.cy[i]), cz = _mm512_loadu_ps(&in.cz[i]);
+            __m512 anx = _mm512_loadu_ps(&in.anx[i]), any = _mm512_loadu_ps(&in.any[i]), anz = _mm512_loadu_ps(&in.anz[i]);
+            __m512 bnx = _mm512_loadu_ps(&in.bnx[i]), bny = _mm512_loadu_ps(&in.bny[i]), bnz = _mm512_loadu_ps(&in.bnz[i]);
+            __m512 sx = _mm512_sub_ps(_mm512_add_ps(ax, cx), _mm512_add_ps(bx, ex));
+            __m512 sy = _mm512_sub_ps(_mm512_add_ps(ay, cy), _mm512_add_ps(by, ey));
+            __m512 sz = _mm512_sub_ps(_mm512_add_ps(az, cz), _mm512_add_ps(bz, ez));
+            __m512 convex = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(sx, _mm512_add_ps(anx, bnx)), _mm512_mul_ps(sy, _mm512_add_ps(any, bny))), _mm512_mul_ps(sz, _mm512_add_ps(anz, bnz)));
+            __m512 eta = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(convex, _mm512_setzero_ps(), _CMP_LT_OQ), vconcave, vconvex);
+            __m512 dn = _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(anx, bnx), _mm512_mul_ps(any, bny)), _mm512_mul_ps(anz, bnz));
+            _mm512_storeu_ps(ang+i, _mm512_mul_ps(eta, _mm512_sub_ps(one, dn)));
+            __m512 px = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(bx, ex), ax), three), bx);
+            __m512 py = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(by, ey), ay), three), by);
+            __m512 pz = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(bz, ez), az), three), bz);
+            __m512 qx = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(bx, ex), cx), three), bx);
+            __m512 qy = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(by, ey), cy), three), by);
+            __m512 qz = _mm512_sub_ps(_mm512_div_ps(_mm512_add_ps(_mm512_add_ps(bz, ez), cz), three), bz);
+            __m512 dx = _mm512_sub_ps(ex, bx), dy = _mm512_sub_ps(ey, by), dz = _mm512_sub_ps(ez, bz);
+            __m512 a = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(px, px), _mm512_mul_ps(py, py)), _mm512_mul_ps(pz, pz)));
+            __m512 b = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(qx, qx), _mm512_mul_ps(qy, qy)), _mm512_mul_ps(qz, qz)));
+            __m512 invc = _mm512_div_ps(one, _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy)), _mm512_mul_ps(dz, dz))));
+            __m512 cost_1 = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_div_ps(px, a), dx), _mm512_mul_ps(_mm512_div_ps(py, a), dy)), _mm512_mul_ps(_mm512_div_ps(pz, a), dz)), invc);
+            __m512 cost_2 = _mm512_mul_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(_mm512_div_ps(qx, b), dx), _mm512_mul_ps(_mm512_div_ps(qy, b), dy)), _mm512_mul_ps(_mm512_div_ps(qz, b), dz)), invc);
+            __m512 sine = _mm512_mul_ps(_mm512_sqrt_ps(_mm512_sub_ps(one, _mm512_mul_ps(cost_1, cost_1))), _mm512_sqrt_ps(_mm512_sub_ps(one, _mm512_mul_ps(cost_2, cost_2))));
+            __m512 cost = _mm512_sub_ps(_mm512_mul_ps(cost_1, cost_2), sine);
+            __m512 g = _mm512_sub_ps(_mm512_add_ps(_mm512_mul_ps(a, a), _mm512_mul_ps(b, b)), _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(two, a), b), cost));
+            _mm512_storeu_ps(geo+i, _mm512_sqrt_ps(g));
+        }
+        scalar(in, i, end, etaConvex, etaConcave, ang, geo);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+    // picked once from the running cpu
+    static EdgeKernel select(){
+#ifdef EDGEKERNELS_X86_SIMD
+        if(__builtin_cpu_supports("avx512f")){
+            return avx512;
+        }
+        if(__builtin_cpu_supports("avx2")){
+            return avx2;
+        }
+        if(__builtin_cpu_supports("sse4.1")){
+            return sse4;
+        }
+#endif
+        return scalar;
+    }
+};
+#endif
@@ -0,0 +1,305 @@
+#ifndef EXPANSION_H
+#define EXPANSION_H
+#include <vector>
+#include <algorithm>
+#include "dualgraph.h"
+#include "matrix.h"
+#include "topmembership.h"
+#include "flowgraph.h"
+#include "bkflow.h"
+using namespace std;
+// alpha expansion over the fuzzy boundaries of a k-way labelling, all patches in one
+// pass instead of a min cut per pair. A face is fuzzy if its two best probabilities are
+// within 2*delta (|p-0.5|<delta for two patches) and may take any label whose probability
+// is that close to its best; the other faces keep their label. The energy is the
+// capacity of the dual edges between different labels, the potts model the two way cut
+// minimises. An expansion of alpha lets every fuzzy face switch to alpha in one min cut
+// (boykov, veksler, zabih); the graph has one node per fuzzy face and one arc pair per
+// edge between them whatever alpha is, so a single residual graph serves all expansions
+// and only the arcs whose capacity changes are touched. Capacities are quantised like
+// --capacity int64 so energies compare exactly. With two patches the result has the
+// energy of the two way cut, but among tied minimum cuts it may keep a different one than
+// the minimal source side fuzzy() reports
+class AlphaExpansion{
+public:
+    // expansions solved, and those that lowered the energy
+    unsigned int expansions;
+    unsigned int accepted;
+    // passes over the labels, the last one changed nothing
+    unsigned int cycles;
+    // augmenting paths of all expansions
+    unsigned int augmentations;
+    // fuzzy faces and the final quantised energy
+    unsigned int regionSize;
+    long long energy;
+
+    AlphaExpansion(){
+        expansions = 0;
+        accepted = 0;
+        cycles = 0;
+        augmentations = 0;
+        regionSize = 0;
+        energy = 0;
+    }
+    // probs are the memberships of every face, DenseMemberships or TopMemberships, caps
+    // the capacity of every dual edge scaled by scale to integers; labels is the starting
+    // labelling and is refined in place
+    template<typename Memberships>
+    void run(const DualGraph& dual, const Memberships& probs, const vector<float>& caps,
+             double scale, float delta, vector<unsigned int>& labels, unsigned int maxCycles=100){
+        unsigned int typen = probs.typen();
+        build(dual, probs, caps, scale, delta, labels);
+        regionSize = faces.size();
+        if(faces.empty()){
+            energy = 0;
+            return;
+        }
+        vector<unsigned int> current(faces.size());
+        for(unsigned int v=0;v<faces.size();v++){
+            current[v] = labels[faces[v]];
+        }
+        energy = cost(current);
+        vector<unsigned int> next(faces.size());
+        for(cycles=1;cycles<=maxCycles;cycles++){
+            bool changed = false;
+            for(unsigned int alpha=0;alpha<typen;alpha++){
+                if(!present[alpha]){
+                    continue;
+                }
+                expand(alpha, current);
+                expansions++;
+                next = current;
+                vector<int> side = solver.cut(source, sink);
+                for(unsigned int i=0;i<side.size();i++){
+                    if((unsigned int)side[i]<faces.size()){
+                        next[side[i]] = alpha;
+                    }
+                }
+                long long e = cost(next);
+                if(e<energy){
+                    energy = e;
+                    current.swap(next);
+                    accepted++;
+                    changed = true;
+                }
+            }
+            if(!changed){
+                break;
+            }
+        }
+        cycles = min(cycles, maxCycles);
+        for(unsigned int v=0;v<faces.size();v++){
+            labels[faces[v]] = current[v];
+        }
+    }
+private:
+    BasicBoykovKolmogorov<long long> solver;
+    unsigned int source;
+    unsigned int sink;
+    // node to face and face to node; the labels each node may take, csr
+    vector<unsigned int> faces;
+    vector<int> local;
+    vector<unsigned int> candidateOffsets;
+    vector<unsigned int> candidates;
+    // labels that are a candidate somewhere, the others have nothing to expand
+    vector<bool> present;
+    // edges between nodes: node pair, arc u->v and capacity
+    vector<unsigned int> edgeU;
+    vector<unsigned int> edgeV;
+    vector<unsigned int> edgeArc;
+    vector<long long> edgeCap;
+    // edges from a node to a fixed face: node, the fixed label and capacity
+    vector<unsigned int> fixedNode;
+    vector<unsigned int> fixedLabel;
+    vector<long long> fixedCap;
+    vector<unsigned int> sourceArc;
+    vector<unsigned int> sinkArc;
+    // terminal capacity no min cut takes: above the cost of keeping every label
+    long long infinite;
+    // costs of a node keeping its label (sink side) or taking alpha (source side)
+    vector<long long> keep;
+    vector<long long> take;
+
+    // fuzzy faces, their candidates, and the graph with every arc at capacity 0
+    template<typename Memberships>
+    void build(const DualGraph& dual, const Memberships& probs, const vector<float>& caps,
+               double scale, float delta, const vector<unsigned int>& labels){
+        unsigned int N = dual.size();
+        unsigned int typen = probs.typen();
+        unsigned int slots = probs.slots();
+        local.assign(N, -1);
+        faces.clear();
+        candidateOffsets.assign(1, 0);
+        candidates.clear();
+        present.assign(typen, false);
+        for(unsigned int i=0;i<N;i++){
+            float best = 0;
+            float second = 0;
+            for(unsigned int s=0;s<slots;s++){
+                float p = probs.value(s, i);
+                if(p>best){
+                    second = best;
+                    best = p;
+                }else if(p>second){
+                    second = p;
+                }
+            }
+            if(best-second>=2*delta){
+                continue;
+            }
+            local[i] = faces.size();
+            faces.push_back(i);
+            // the current label is a candidate even where the slots dropped it
+            bool own = false;
+            for(unsigned int s=0;s<slots;s++){
+                unsigned int j = probs.label(s, i);
+                if(probs.value(s, i)>best-2*delta || j==labels[i]){
+                    candidates.push_back(j);
+                    present[j] = true;
+                    own = own || j==labels[i];
+                }
+            }
+            if(!own){
+                candidates.push_back(labels[i]);
+                present[labels[i]] = true;
+            }
+            candidateOffsets.push_back(candidates.size());
+        }
+        unsigned int n = faces.size();
+        source = n;
+        sink = n+1;
+        vector<FlowEdge> arcs;
+        edgeU.clear();
+        edgeV.clear();
+        edgeCap.clear();
+        fixedNode.clear();
+        fixedLabel.clear();
+        fixedCap.clear();
+        infinite = 1;
+        for(unsigned int v=0;v<n;v++){
+            unsigned int face = faces[v];
+            for(unsigned int k=0;k<dual.degree(face);k++){
+                unsigned int e = dual.edge(face, k);
+                unsigned int other = dual.neighbour(face, k);
+                long long cap = BasicFlowGraph<long long>::quantizeCapacity(caps[e], scale);
+                int w = local[other];
+                if(w<0){
+                    fixedNode.push_back(v);
+                    fixedLabel.push_back(labels[other]);
+                    fixedCap.push_back(cap);
+                    infinite += 4*cap;
+                }else if((unsigned int)w>v){
+                    edgeU.push_back(v);
+                    edgeV.push_back(w);
+                    edgeCap.push_back(cap);
+                    infinite += 4*cap;
+                    FlowEdge edge = {v, (unsigned int)w, 0, 0};
+                    arcs.push_back(edge);
+                }
+            }
+        }
+        for(unsigned int v=0;v<n;v++){
+            FlowEdge in = {source, v, 0, 0};
+            FlowEdge out = {v, sink, 0, 0};
+            arcs.push_back(in);
+            arcs.push_back(out);
+        }
+        BasicFlowGraph<long long>& graph = solver.graph;
+        graph.build(n+2, arcs);
+        sourceArc.assign(n, 0);
+        sinkArc.assign(n, 0);
+        for(unsigned int a=graph.begin(source);a<graph.end(source);a++){
+            sourceArc[graph.heads[a]] = a;
+        }
+        for(unsigned int v=0;v<n;v++){
+            sinkArc[v] = graph.arc(v, sink);
+        }
+        edgeArc.assign(edgeU.size(), 0);
+        for(unsigned int i=0;i<edgeU.size();i++){
+            edgeArc[i] = graph.arc(edgeU[i], edgeV[i]);
+        }
+    }
+    bool candidate(unsigned int v, unsigned int label) const{
+        for(unsigned int c=candidateOffsets[v];c<candidateOffsets[v+1];c++){
+            if(candidates[c]==label){
+                return true;
+            }
+        }
+        return false;
+    }
+    // capacity of the edges between different labels
+    long long cost(const vector<unsigned int>& labels) const{
+        long long e = 0;
+        for(unsigned int i=0;i<edgeU.size();i++){
+            if(labels[edgeU[i]]!=labels[edgeV[i]]){
+                e += edgeCap[i];
+            }
+        }
+        for(unsigned int i=0;i<fixedNode.size();i++){
+            if(labels[fixedNode[i]]!=fixedLabel[i]){
+                e += fixedCap[i];
+            }
+        }
+        return e;
+    }
+    // sets the capacities of the expansion of alpha from labels and solves it
+    void expand(unsigned int alpha, const vector<unsigned int>& labels){
+        BasicFlowGraph<long long>& graph = solver.graph;
+        graph.restore();
+        unsigned int n = faces.size();
+        keep.assign(n, 0);
+        take.assign(n, 0);
+        for(unsigned int v=0;v<n;v++){
+            if(labels[v]==alpha){
+                keep[v] = infinite;
+            }else if(!candidate(v, alpha)){
+                take[v] = infinite;
+            }
+        }
+        for(unsigned int i=0;i<fixedNode.size();i++){
+            unsigned int v = fixedNode[i];
+            keep[v] += labels[v]!=fixedLabel[i] ? fixedCap[i] : 0;
+            take[v] += alpha!=fixedLabel[i] ? fixedCap[i] : 0;
+        }
+        // E(p,q) over x=1 for alpha: E00 = w[lp!=lq], E01 = w[lp!=alpha] (q takes
+        // alpha), E10 = w[alpha!=lq], E11 = 0, written as E00 + (E10-E00)xp - E10 xq +
+        // (E01+E10-E00)(1-xp)xq; the last term is the arc q->p, never negative because
+        // lp and lq cannot both be alpha when they differ
+        for(unsigned int i=0;i<edgeU.size();i++){
+            unsigned int p = edgeU[i];
+            unsigned int q = edgeV[i];
+            long long w = edgeCap[i];
+            long long e00 = labels[p]!=labels[q] ? w : 0;
+            long long e01 = labels[p]!=alpha ? w : 0;
+            long long e10 = alpha!=labels[q] ? w : 0;
+            if(e10>=e00){
+                take[p] += e10-e00;
+            }else{
+                keep[p] += e00-e10;
+            }
+            keep[q] += e10;
+            set(edgeArc[i], 0, e01+e10-e00);
+        }
+        for(unsigned int v=0;v<n;v++){
+            long long m = min(keep[v], take[v]);
+            set(sourceArc[v], keep[v]-m, 0);
+            set(sinkArc[v], take[v]-m, 0);
+        }
+        solver.resume(source, sink);
+        augmentations += solver.augmentations;
+    }
+    // capacity of the arc a and of its twin, with no flow on them
+    void set(unsigned int a, long long cap, long long rcap){
+        BasicFlowGraph<long long>& graph = solver.graph;
+        unsigned int b = graph.twins[a];
+        if(graph.capacity[a]==cap && graph.capacity[b]==rcap){
+            return;
+        }
+        graph.touch(a);
+        graph.capacity[a] = cap;
+        graph.capacity[b] = rcap;
+        graph.residual[a] = cap;
+        graph.residual[b] = rcap;
+    }
+};
+#endif
@@ -0,0 +1,290 @@
+#include "dimacs.h"
+#include "netflow.h"
+#include "bkflow.h"
+#include "pushrelabel.h"
+#include "dinic.h"
+#include "threadpool.h"
+#include "profiler.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+using namespace std;
+
+// runs every max-flow solver on DIMACS instances (meshdecomp --dimacs dumps) and compares
+// time, memory and cut value, each solver in a process of its own; exits with 1 if the
+// solvers disagree on a cut:
+// meshdecomp_flowcmp [--solvers ff,bk,pr,ppr,dinic] [--reps 3] [--threads n]
+//                    [--ff-limit 4096] [--capacity float|int64] [--scale s] [--csv f] file.max...
+
+struct FlowResult{
+    string file;
+    string solver;
+    unsigned int nodes;
+    unsigned int arcs;
+    double min;
+    double median;
+    long peakRssDelta;
+    double cut;
+};
+
+static vector<FlowResult> results;
+
+static double seconds(chrono::steady_clock::time_point start){
+    return chrono::duration<double>(chrono::steady_clock::now()-start).count();
+}
+
+static vector<string> split(const string& s){
+    vector<string> parts;
+    stringstream in(s);
+    string part;
+    while(getline(in, part, ',')){
+        if(!part.empty()){
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+// capacity of the arcs leaving the source side in the original graph
+static double cutValue(const FlowGraph& graph, const vector<int>& side){
+    vector<bool> inside(graph.size(), false);
+    for(unsigned int i=0;i<side.size();i++){
+        inside[side[i]] = true;
+    }
+    double value = 0;
+    for(unsigned int i=0;i<side.size();i++){
+        for(unsigned int a=graph.begin(side[i]);a<graph.end(side[i]);a++){
+            if(!inside[graph.heads[a]]){
+                value += graph.capacity[a];
+            }
+        }
+    }
+    return value;
+}
+
+// what a measured run sends back: times, peak rss growth and the cut
+struct Measurement{
+    double min;
+    double median;
+    long peakRssDelta;
+    double cut;
+};
+
+// setup builds the solver and is timed only for memory, ff is timed per repetition
+template<typename Setup>
+static void measure(const FlowGraph& graph, unsigned int reps, Setup setup, Measurement& m){
+    long rssStart = Profiler::peakRss();
+    vector<double> times;
+    vector<int> side;
+    for(unsigned int r=0;r<reps;r++){
+        side = setup(times);
+    }
+    sort(times.begin(), times.end());
+    m.min = times[0];
+    m.median = times[times.size()/2];
+    m.peakRssDelta = Profiler::peakRss()-rssStart;
+    m.cut = cutValue(graph, side);
+}
+
+// each solver runs in a child process of its own: the peak resident set only grows, so
+// in one process the first solver to allocate would take all the growth and the others
+// would show 0. The child starts with its peak at the current resident set and the thread
+// pool is first created there, the parent never runs a solver
+template<typename Setup>
+static void run(const string& file, const string& solver, const FlowGraph& graph, unsigned int reps, Setup setup){
+    Measurement m;
+#ifdef _WIN32
+    measure(graph, reps, setup, m);
+#else
+    int fds[2];
+    if(pipe(fds)!=0){
+        cout<<file<<"\t"<<solver<<"\tpipe failed"<<endl;
+        return;
+    }
+    pid_t pid = fork();
+    if(pid==0){
+        close(fds[0]);
+        measure(graph, reps, setup, m);
+        bool sent = write(fds[1], &m, sizeof(m))==(ssize_t)sizeof(m);
+        _exit(sent ? 0 : 1);
+    }
+    close(fds[1]);
+    bool received = pid>0 && read(fds[0], &m, sizeof(m))==(ssize_t)sizeof(m);
+    close(fds[0]);
+    if(pid>0){
+        waitpid(pid, NULL, 0);
+    }
+    if(!received){
+        cout<<file<<"\t"<<solver<<"\tfailed"<<endl;
+        return;
+    }
+#endif
+    FlowResult result;
+    result.file = file;
+    result.solver = solver;
+    result.nodes = graph.size();
+    result.arcs = graph.arcCount();
+    result.min = m.min;
+    result.median = m.median;
+    result.peakRssDelta = m.peakRssDelta;
+    result.cut = m.cut;
+    results.push_back(result);
+    cout<<file<<"\t"<<solver<<"\t"<<result.median<<" s\t"<<result.peakRssDelta<<" kB\tcut "<<result.cut<<endl;
+}
+
+template<typename Solver>
+static vector<int> solve(Solver& gr, unsigned int s, unsigned int d, vector<double>& times){
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    gr.ff(s, d);
+    times.push_back(seconds(start));
+    return gr.cut(s, d);
+}
+
+// a csr solver on the float graph, or on its capacities quantised to long long
+template<typename Float, typename Integer>
+static void runCsr(const string& file, const string& solver, const FlowGraph& graph, unsigned int s, unsigned int d,
+                   unsigned int reps, CapacityMode capacity, double scale){
+    if(capacity==FLOAT_CAPACITY){
+        run(file, solver, graph, reps, [&](vector<double>& times){
+            Float gr;
+            gr.graph = graph;
+            return solve(gr, s, d, times);
+        });
+        return;
+    }
+    run(file, solver, graph, reps, [&](vector<double>& times){
+        Integer gr;
+        gr.graph.quantize(graph, scale, s, d);
+        return solve(gr, s, d, times);
+    });
+}
+
+static void compareFile(const string& file, const vector<string>& solvers, unsigned int reps, unsigned int ffLimit,
+                        CapacityMode capacity, double scale){
+    unsigned int n, s, d;
+    vector<FlowEdge> edges;
+    if(!loadDimacs(file, n, edges, s, d)){
+        cout<<"failed to load "<<file<<endl;
+        return;
+    }
+    FlowGraph graph;
+    graph.build(n, edges);
+    for(unsigned int i=0;i<solvers.size();i++){
+        const string& solver = solvers[i];
+        if(solver=="ff"){
+            if(n>ffLimit){
+                cout<<file<<"\tff\tskipped, "<<n<<" nodes"<<endl;
+                continue;
+            }
+            run(file, solver, graph, reps, [&](vector<double>& times){
+                Matrix<float> cap(n, n);
+                cap.fill(-1);
+                for(unsigned int j=0;j<edges.size();j++){
+                    cap[edges[j].u][edges[j].v] = edges[j].cap;
+                    cap[edges[j].v][edges[j].u] = edges[j].rcap;
+                }
+                FordFulkerson gr(cap);
+                return solve(gr, s, d, times);
+            });
+        }else if(solver=="bk"){
+            runCsr<BoykovKolmogorov, BasicBoykovKolmogorov<long long>>(file, solver, graph, s, d, reps, capacity, scale);
+        }else if(solver=="pr"){
+            runCsr<PushRelabel, BasicPushRelabel<long long>>(file, solver, graph, s, d, reps, capacity, scale);
+        }else if(solver=="ppr"){
+            runCsr<ParallelPushRelabel, BasicParallelPushRelabel<long long>>(file, solver, graph, s, d, reps, capacity, scale);
+        }else if(solver=="dinic"){
+            runCsr<Dinic, BasicDinic<long long>>(file, solver, graph, s, d, reps, capacity, scale);
+        }else{
+            cout<<"unknown solver "<<solver<<endl;
+        }
+    }
+}
+
+static void saveCsv(const string& path){
+    ofstream out(path);
+    out<<"file,solver,nodes,arcs,min_s,median_s,peak_rss_delta_kb,cut"<<endl;
+    out.precision(12);
+    for(unsigned int i=0;i<results.size();i++){
+        const FlowResult& r = results[i];
+        out<<r.file<<","<<r.solver<<","<<r.nodes<<","<<r.arcs<<","<<r.min<<","<<r.median<<","<<r.peakRssDelta<<","<<r.cut<<endl;
+    }
+}
+
+// solvers of one file agree if their cut values match up to float rounding
+static bool consistent(){
+    bool ok = true;
+    for(unsigned int i=1;i<results.size();i++){
+        const FlowResult& first = results[i-1];
+        const FlowResult& r = results[i];
+        if(r.file!=first.file){
+            continue;
+        }
+        if(fabs(r.cut-first.cut)>1e-4*max(1.0, fabs(first.cut))){
+            cout<<"MISMATCH "<<r.file<<": "<<first.solver<<" "<<first.cut<<", "<<r.solver<<" "<<r.cut<<endl;
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<string> solvers = split("ff,bk,pr,ppr,dinic");
+    vector<string> files;
+    unsigned int reps = 3;
+    unsigned int threads = 0;
+    unsigned int ffLimit = 4096;
+    CapacityMode capacity = FLOAT_CAPACITY;
+    double scale = 65536;
+    string csv;
+    for(int i=1;i<argc;i++){
+        string arg = argv[i];
+        if(arg[0]!='-'){
+            files.push_back(arg);
+            continue;
+        }
+        if(i+1>=argc){
+            cout<<"missing value for "<<arg<<endl;
+            return 2;
+        }
+        string value = argv[++i];
+        if(arg=="--solvers"){
+            solvers = split(value);
+        }else if(arg=="--reps"){
+            reps = max(1, atoi(value.c_str()));
+        }else if(arg=="--threads"){
+            threads = atoi(value.c_str());
+        }else if(arg=="--ff-limit"){
+            ffLimit = atoi(value.c_str());
+        }else if(arg=="--capacity" && (value=="float" || value=="int64")){
+            capacity = value=="float" ? FLOAT_CAPACITY : INT64_CAPACITY;
+        }else if(arg=="--scale"){
+            scale = atof(value.c_str());
+        }else if(arg=="--csv"){
+            csv = value;
+        }else{
+            cout<<"unknown option "<<arg<<endl;
+            return 2;
+        }
+    }
+    if(files.empty()){
+        cout<<"usage: "<<argv[0]<<" [--solvers ff,bk,pr,ppr,dinic] [--reps n] [--threads n] [--ff-limit n] [--capacity float|int64] [--scale s] [--csv f] file.max..."<<endl;
+        return 2;
+    }
+    ThreadPool::configure(threads);
+    for(unsigned int i=0;i<files.size();i++){
+        compareFile(files[i], solvers, reps, ffLimit, capacity, scale);
+    }
+    if(!csv.empty()){
+        saveCsv(csv);
+    }
+    return consistent() ? 0 : 1;
+}
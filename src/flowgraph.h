@@ -0,0 +1,248 @@
+#ifndef FLOWGRAPH_H
+#define FLOWGRAPH_H
+#include <vector>
+#include <limits>
+#include <cmath>
+#include "matrix.h"
+#include "bfs.h"
+using namespace std;
+// max-flow engines behind the ff/cut interface, picked by Mesh::fuzzy
+enum MaxFlowSolver{
+    FORD_FULKERSON,
+    BOYKOV_KOLMOGOROV,
+    PUSH_RELABEL,
+    PARALLEL_PUSH_RELABEL,
+    DINIC
+};
+// arithmetic of the residual capacities: float, or fuzzy capacities quantised to
+// integers by BasicFlowGraph::quantize so saturation and termination are exact
+enum CapacityMode{
+    FLOAT_CAPACITY,
+    INT32_CAPACITY,
+    INT64_CAPACITY
+};
+// capacities from here on are infinite when quantised, like the 1e10 terminal arcs
+#define FLOW_INFINITE_CAPACITY 1e9f
+// one undirected pair of arcs, cap from u to v and rcap from v to u
+struct FlowEdge{
+    unsigned int u;
+    unsigned int v;
+    float cap;
+    float rcap;
+};
+// residual graph in csr form: the arcs of node v are [offsets[v], offsets[v+1]) and
+// every arc knows its reverse arc, O(V+E) memory instead of the dense N*N matrices.
+// Cap is the capacity type, FlowGraph the float graph of the fuzzy region
+template<typename Cap>
+class BasicFlowGraph{
+public:
+    vector<unsigned int> offsets;
+    vector<unsigned int> heads;
+    vector<unsigned int> twins;
+    vector<Cap> capacity;
+    vector<Cap> residual;
+    // arcs changed through touch since the last restore, with their epoch stamps
+    vector<unsigned int> touched;
+    vector<unsigned int> arcEpoch;
+    unsigned int epoch;
+
+    BasicFlowGraph(){
+        epoch = 1;
+    }
+
+    unsigned int size() const{
+        return offsets.size()>0 ? offsets.size()-1 : 0;
+    }
+    unsigned int arcCount() const{
+        return heads.size();
+    }
+    unsigned int begin(unsigned int v) const{
+        return offsets[v];
+    }
+    unsigned int end(unsigned int v) const{
+        return offsets[v+1];
+    }
+    // the arc u->v, arcCount() if there is none
+    unsigned int arc(unsigned int u, unsigned int v) const{
+        for(unsigned int a=begin(u);a<end(u);a++){
+            if(heads[a]==v){
+                return a;
+            }
+        }
+        return arcCount();
+    }
+    // a float capacity times scale rounded to an integer, positive capacities at least 1
+    // so no arc disappears; the rounding of quantize and of every integer fuzzy graph
+    static long long quantizeCapacity(double cap, double scale){
+        return cap>0 ? (long long)max(1.0, floor(cap*scale+0.5)) : 0;
+    }
+    void build(unsigned int n, const vector<FlowEdge>& edges){
+        offsets.assign(n+1, 0);
+        for(unsigned int i=0;i<edges.size();i++){
+            offsets[edges[i].u+1]++;
+            offsets[edges[i].v+1]++;
+        }
+        for(unsigned int v=0;v<n;v++){
+            offsets[v+1] += offsets[v];
+        }
+        unsigned int m = offsets[n];
+        heads.resize(m);
+        twins.resize(m);
+        capacity.resize(m);
+        vector<unsigned int> next(offsets.begin(), offsets.end()-1);
+        for(unsigned int i=0;i<edges.size();i++){
+            const FlowEdge& e = edges[i];
+            unsigned int a = next[e.u]++;
+            unsigned int b = next[e.v]++;
+            heads[a] = e.v;
+            heads[b] = e.u;
+            twins[a] = b;
+            twins[b] = a;
+            capacity[a] = (Cap)e.cap;
+            capacity[b] = (Cap)e.rcap;
+        }
+        resetTouched();
+    }
+    // same convention as FordFulkerson: -1 is no edge, distance[i][j] the capacity i->j
+    void build(const Matrix<float>& distance){
+        unsigned int n = distance.rows();
+        vector<FlowEdge> edges;
+        for(unsigned int i=0;i<n;i++){
+            for(unsigned int j=i+1;j<n;j++){
+                if(distance[i][j]!=-1 || distance[j][i]!=-1){
+                    FlowEdge e;
+                    e.u = i;
+                    e.v = j;
+                    e.cap = distance[i][j]!=-1 ? distance[i][j] : 0;
+                    e.rcap = distance[j][i]!=-1 ? distance[j][i] : 0;
+                    edges.push_back(e);
+                }
+            }
+        }
+        build(n, edges);
+    }
+    // same arcs as graph with the capacities times scale rounded to integers; positive
+    // capacities stay at least 1 so no arc disappears, and an infinite arc gets one more
+    // than the finite capacity around a non terminal end, which no s-d flow can saturate.
+    // returns false if a node's capacities could overflow Cap during a solve
+    template<typename From>
+    bool quantize(const BasicFlowGraph<From>& graph, double scale, unsigned int s, unsigned int d){
+        offsets = graph.offsets;
+        heads = graph.heads;
+        twins = graph.twins;
+        unsigned int n = graph.size();
+        unsigned int m = graph.arcCount();
+        vector<double> q(m);
+        vector<bool> infinite(m);
+        // finite capacity at each node in both directions, and its infinite arcs
+        vector<double> finite(n, 0);
+        vector<unsigned int> infinites(n, 0);
+        double finiteTotal = 0;
+        for(unsigned int a=0;a<m;a++){
+            infinite[a] = graph.capacity[a]>=FLOW_INFINITE_CAPACITY;
+        }
+        for(unsigned int v=0;v<n;v++){
+            for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+                if(infinite[a] || infinite[twins[a]]){
+                    infinites[v]++;
+                }
+                if(infinite[a]){
+                    continue;
+                }
+                q[a] = quantizeCapacity(graph.capacity[a], scale);
+                finite[v] += q[a];
+                finite[heads[a]] += q[a];
+                finiteTotal += q[a];
+            }
+        }
+        for(unsigned int v=0;v<n;v++){
+            for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+                if(!infinite[a]){
+                    continue;
+                }
+                // the flow through a also passes the other arcs of an end that is not a
+                // terminal, so they bound it if they are all finite
+                unsigned int w = heads[a];
+                double bound = finiteTotal;
+                if(v!=s && v!=d && infinites[v]==1){
+                    bound = min(bound, finite[v]);
+                }
+                if(w!=s && w!=d && infinites[w]==1){
+                    bound = min(bound, finite[w]);
+                }
+                q[a] = bound+1;
+            }
+        }
+        // residuals reach cap+rcap and excesses the sum around a node
+        double limit = (double)numeric_limits<Cap>::max();
+        for(unsigned int v=0;v<n;v++){
+            double load = 0;
+            for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+                load += q[a]+q[twins[a]];
+            }
+            if(load>limit){
+                return false;
+            }
+        }
+        capacity.resize(m);
+        for(unsigned int a=0;a<m;a++){
+            capacity[a] = (Cap)q[a];
+        }
+        resetTouched();
+        return true;
+    }
+    void reset(){
+        residual = capacity;
+        touched.clear();
+        nextEpoch();
+    }
+    // record an arc pair about to change, for solvers that reset through restore
+    void touch(unsigned int a){
+        if(arcEpoch[a]!=epoch){
+            arcEpoch[a] = epoch;
+            arcEpoch[twins[a]] = epoch;
+            touched.push_back(a);
+        }
+    }
+    // reset in O(touched): only valid if every residual change went through touch
+    void restore(){
+        for(unsigned int i=0;i<touched.size();i++){
+            unsigned int a = touched[i];
+            residual[a] = capacity[a];
+            residual[twins[a]] = capacity[twins[a]];
+        }
+        touched.clear();
+        nextEpoch();
+    }
+    void nextEpoch(){
+        epoch++;
+        if(epoch==0){
+            arcEpoch.assign(arcEpoch.size(), 0);
+            epoch = 1;
+        }
+    }
+    // flow leaving s
+    Cap flowValue(unsigned int s) const{
+        Cap value = 0;
+        for(unsigned int a=begin(s);a<end(s);a++){
+            value += capacity[a]-residual[a];
+        }
+        return value;
+    }
+    // source side of the min cut: reachable from s through unsaturated residual arcs,
+    // in bfs level order like FordFulkerson::cut
+    vector<int> sourceSide(unsigned int s, unsigned int d) const{
+        FrontierBfs bfs;
+        bfs.run(ResidualView<BasicFlowGraph<Cap>>(*this), s, d);
+        return vector<int>(bfs.order.begin(), bfs.order.end());
+    }
+private:
+    void resetTouched(){
+        residual = capacity;
+        touched.clear();
+        arcEpoch.assign(capacity.size(), 0);
+        epoch = 1;
+    }
+};
+typedef BasicFlowGraph<float> FlowGraph;
+#endif
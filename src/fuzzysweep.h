@@ -0,0 +1,241 @@
+#ifndef FUZZYSWEEP_H
+#define FUZZYSWEEP_H
+#include <vector>
+#include <algorithm>
+#include "dualgraph.h"
+#include "flowgraph.h"
+#include "bkflow.h"
+using namespace std;
+// the fuzzy region cuts of a list of deltas on one flow graph. The region only grows
+// with delta, so every face that can take part is a node from the start and a delta
+// just sets the capacities: the edges with a fuzzy end, and terminal arcs for the A and
+// B faces. The flow of the previous delta stays feasible: an edge only gains capacity,
+// and a face leaving A or B keeps the flow of its terminal arc by adding the same amount
+// to both of its terminal arcs, which moves every cut by a constant. The terminal arcs
+// are bounded by the edge capacity around the face plus one instead of 1e10, which no
+// min cut saturates either. The capacities are quantised like --capacity int64: in float
+// the flows carried over pick up rounding dust, and a residual of 1e-6 left on an arc
+// that should be saturated changes the reachable set the cut is read from
+class FuzzySweep{
+public:
+    // solves that kept the previous flow, and those that had to start from zero
+    unsigned int warmStarts;
+    unsigned int coldStarts;
+    // augmenting paths of all solves
+    unsigned int augmentations;
+
+    FuzzySweep(){
+        warmStarts = 0;
+        coldStarts = 0;
+        augmentations = 0;
+    }
+    // probs is the type 0 probability of every face, caps the capacity of every dual
+    // edge, scaled by scale to integers; returns per delta, in the given order, 0 for the
+    // faces of the fuzzy region on the source (A) side, 1 for the other region faces and
+    // -1 outside the region
+    vector<vector<int>> run(const DualGraph& dual, const float* probs, const vector<float>& caps, double scale, const vector<float>& deltas){
+        vector<vector<int>> sides(deltas.size());
+        if(deltas.empty()){
+            return sides;
+        }
+        vector<unsigned int> order(deltas.size());
+        for(unsigned int i=0;i<order.size();i++){
+            order[i] = i;
+        }
+        sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b){
+            return deltas[a]<deltas[b];
+        });
+        build(dual, probs, caps, scale, deltas[order.back()]);
+        bool first = true;
+        for(unsigned int i=0;i<order.size();i++){
+            bool warm = update(dual, probs, deltas[order[i]]);
+            if(!warm){
+                solver.graph.restore();
+            }
+            if(!first){
+                if(warm){
+                    warmStarts++;
+                }else{
+                    coldStarts++;
+                }
+            }
+            first = false;
+            solver.resume(source, sink);
+            augmentations += solver.augmentations;
+            vector<int> cut = solver.cut(source, sink);
+            vector<int>& side = sides[order[i]];
+            side.assign(dual.size(), -1);
+            for(unsigned int v=0;v<faces.size();v++){
+                if(state[v]!=OUTSIDE){
+                    side[faces[v]] = 1;
+                }
+            }
+            for(unsigned int j=0;j<cut.size();j++){
+                if((unsigned int)cut[j]<faces.size()){
+                    side[faces[cut[j]]] = 0;
+                }
+            }
+        }
+        return sides;
+    }
+private:
+    enum{OUTSIDE = 0, A_SIDE = 1, FUZZY = 2, B_SIDE = 3};
+    BasicBoykovKolmogorov<long long> solver;
+    unsigned int source;
+    unsigned int sink;
+    // node to face, and per node its state, terminal arcs and their bound
+    vector<unsigned int> faces;
+    vector<int> local;
+    vector<unsigned char> state;
+    vector<unsigned int> sourceArc;
+    vector<unsigned int> sinkArc;
+    vector<long long> bound;
+    // added to both terminal arcs of a node to keep its old terminal flow feasible
+    vector<long long> offset;
+    // dual edges between nodes, their arc from the left face and capacity
+    vector<unsigned int> edges;
+    vector<unsigned int> edgeArc;
+    vector<long long> edgeCap;
+
+    static bool fuzzy(float p, float delta){
+        return p>(0.5-delta) && p<(0.5+delta);
+    }
+    // the faces of the largest region and its neighbours, with every arc at capacity 0
+    void build(const DualGraph& dual, const float* probs, const vector<float>& caps, double scale, float delta){
+        unsigned int N = dual.size();
+        local.assign(N, -1);
+        faces.clear();
+        for(unsigned int i=0;i<N;i++){
+            if(!fuzzy(probs[i], delta)){
+                continue;
+            }
+            if(local[i]<0){
+                local[i] = faces.size();
+                faces.push_back(i);
+            }
+            for(unsigned int k=0;k<dual.degree(i);k++){
+                unsigned int n = dual.neighbour(i, k);
+                if(local[n]<0){
+                    local[n] = faces.size();
+                    faces.push_back(n);
+                }
+            }
+        }
+        unsigned int n = faces.size();
+        source = n;
+        sink = n+1;
+        vector<FlowEdge> arcs;
+        edges.clear();
+        bound.assign(n, 1);
+        for(unsigned int v=0;v<n;v++){
+            unsigned int face = faces[v];
+            for(unsigned int k=0;k<dual.degree(face);k++){
+                unsigned int e = dual.edge(face, k);
+                int w = local[dual.neighbour(face, k)];
+                if(w<0){
+                    continue;
+                }
+                bound[v] += BasicFlowGraph<long long>::quantizeCapacity(caps[e], scale);
+                if(dual.left[e]==face){
+                    edges.push_back(e);
+                    FlowEdge edge = {v, (unsigned int)w, 0, 0};
+                    arcs.push_back(edge);
+                }
+            }
+        }
+        for(unsigned int v=0;v<n;v++){
+            FlowEdge in = {source, v, 0, 0};
+            FlowEdge out = {v, sink, 0, 0};
+            arcs.push_back(in);
+            arcs.push_back(out);
+        }
+        BasicFlowGraph<long long>& graph = solver.graph;
+        graph.build(n+2, arcs);
+        sourceArc.assign(n, 0);
+        sinkArc.assign(n, 0);
+        for(unsigned int a=graph.begin(source);a<graph.end(source);a++){
+            sourceArc[graph.heads[a]] = a;
+        }
+        edgeArc.assign(edges.size(), 0);
+        edgeCap.assign(edges.size(), 0);
+        for(unsigned int i=0;i<edges.size();i++){
+            edgeArc[i] = graph.arc(local[dual.left[edges[i]]], local[dual.right[edges[i]]]);
+            edgeCap[i] = BasicFlowGraph<long long>::quantizeCapacity(caps[edges[i]], scale);
+        }
+        for(unsigned int v=0;v<n;v++){
+            sinkArc[v] = graph.arc(v, sink);
+        }
+        state.assign(n, OUTSIDE);
+        offset.assign(n, 0);
+    }
+    // sets the capacities of delta around the current flow, false if an edge lost
+    // capacity below its flow and the solve has to start from zero
+    bool update(const DualGraph& dual, const float* probs, float delta){
+        unsigned int n = faces.size();
+        for(unsigned int v=0;v<n;v++){
+            state[v] = fuzzy(probs[faces[v]], delta) ? FUZZY : OUTSIDE;
+        }
+        // like fuzzyConstruct: the neighbours of the fuzzy faces strictly outside the band
+        for(unsigned int v=0;v<n;v++){
+            if(state[v]!=FUZZY){
+                continue;
+            }
+            unsigned int face = faces[v];
+            for(unsigned int k=0;k<dual.degree(face);k++){
+                int w = local[dual.neighbour(face, k)];
+                if(w<0 || state[w]==FUZZY){
+                    continue;
+                }
+                float p = probs[faces[w]];
+                if(p>0.5+delta){
+                    state[w] = A_SIDE;
+                }else if(p<0.5-delta){
+                    state[w] = B_SIDE;
+                }
+            }
+        }
+        BasicFlowGraph<long long>& graph = solver.graph;
+        bool warm = true;
+        for(unsigned int i=0;i<edges.size();i++){
+            unsigned int u = local[dual.left[edges[i]]];
+            unsigned int w = local[dual.right[edges[i]]];
+            bool active = (state[u]==FUZZY || state[w]==FUZZY) && state[u]!=OUTSIDE && state[w]!=OUTSIDE;
+            long long cap = active ? edgeCap[i] : 0;
+            unsigned int a = edgeArc[i];
+            unsigned int b = graph.twins[a];
+            if(graph.capacity[a]==cap){
+                continue;
+            }
+            // net flow u -> w, both arcs of an edge have the same capacity
+            long long flow = graph.capacity[a]-graph.residual[a];
+            if(flow>cap || -flow>cap){
+                warm = false;
+            }
+            graph.touch(a);
+            graph.capacity[a] = cap;
+            graph.capacity[b] = cap;
+            graph.residual[a] = cap-flow;
+            graph.residual[b] = cap+flow;
+        }
+        for(unsigned int v=0;v<n;v++){
+            unsigned int a = sourceArc[v];
+            unsigned int b = sinkArc[v];
+            long long in = state[v]==A_SIDE ? bound[v] : 0;
+            long long out = state[v]==B_SIDE ? bound[v] : 0;
+            if(graph.capacity[a]==in+offset[v] && graph.capacity[b]==out+offset[v]){
+                continue;
+            }
+            long long inFlow = graph.capacity[a]-graph.residual[a];
+            long long outFlow = graph.capacity[b]-graph.residual[b];
+            offset[v] = max(offset[v], max(inFlow-in, outFlow-out));
+            graph.touch(a);
+            graph.touch(b);
+            graph.capacity[a] = in+offset[v];
+            graph.capacity[b] = out+offset[v];
+            graph.residual[a] = graph.capacity[a]-inFlow;
+            graph.residual[b] = graph.capacity[b]-outFlow;
+        }
+        return warm;
+    }
+};
+#endif
@@ -10,6 +10,8 @@
 #include "shader.h"
 #include "camera.h"
 #include "model.h"
+#include "renderer.h"
+#include "meshdecomp.h"
 
 #include <iostream>
 
@@ -44,11 +46,24 @@ int main(int argc, char* argv[])
         // objfile = "resources/objects/tetrahedron.obj";
     }
     bool drawmode = false;
-    // default decomposition
-    if(argc>2){
-        drawmode = true;
+    // full distance matrices are only needed for small models and reference runs
+    DecompositionOptions options;
+    for(int i=2;i<argc;i++){
+        if(string(argv[i])=="--dense"){
+            options.distanceMode = DENSE_DIJKSTRA;
+        }else if(string(argv[i])=="--floyd"){
+            options.distanceMode = DENSE_FLOYD;
+        }else{
+            // default decomposition
+            drawmode = true;
+        }
+    }
+    // decomposition needs no window, same path as the meshdecomp cli
+    if(!drawmode){
+        string output = objfile+string("decompositionfuzzy.obj");
+        return decomposeFile(objfile, output, options) ? 0 : -1;
     }
-    
+
 
     // glfw: initialize and configure
     // ------------------------------
@@ -101,15 +116,8 @@ int main(int argc, char* argv[])
     // load models
     // -----------
     
-    Model ourModel(objfile,!drawmode);
-    if(!drawmode){
-        string output = objfile+string("decompositionfuzzy.obj");
-        ourModel.simple();
-        ourModel.fuzzy();
-        // ourModel.saveAs(output);
-        ourModel.saveAs(output);
-        return 0;
-    }
+    Model ourModel(objfile);
+    ModelRenderer ourRenderer(ourModel);
     
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -161,7 +169,7 @@ int main(int argc, char* argv[])
         ourShader.setVec3("material.diffuse", 1.0f, 0.5f, 0.31f);
         ourShader.setVec3("material.specular", 0.5f, 0.5f, 0.5f); // specular lighting doesn't have full effect on this object's material
         ourShader.setFloat("material.shininess", 32.0f);
-        ourModel.Draw(ourShader);
+        ourRenderer.Draw(ourShader);
 
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
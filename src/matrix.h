@@ -0,0 +1,155 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+using namespace std;
+// row alignment in bytes, one cache line / one avx-512 register
+#define MATRIX_ALIGN 64
+// alignment used when huge pages are requested
+#define MATRIX_HUGE_PAGE (2*1024*1024)
+// owning rows*cols matrix in one aligned allocation; every row starts on a cache line,
+// m[i] is a pointer to row i so m[i][j] reads like the old T** arrays
+template<typename T>
+class Matrix{
+public:
+    Matrix(){
+        buffer = NULL;
+        nrows = 0;
+        ncols = 0;
+        rowStride = 0;
+        bytes = 0;
+    }
+    Matrix(size_t rows, size_t cols, bool hugePages=false){
+        buffer = NULL;
+        allocate(rows, cols, hugePages);
+    }
+    ~Matrix(){
+        release();
+    }
+    Matrix(const Matrix&) = delete;
+    Matrix& operator=(const Matrix&) = delete;
+    Matrix(Matrix&& other){
+        buffer = NULL;
+        take(other);
+    }
+    Matrix& operator=(Matrix&& other){
+        if(this!=&other){
+            release();
+            take(other);
+        }
+        return *this;
+    }
+    T* operator[](size_t i){
+        return buffer+i*rowStride;
+    }
+    const T* operator[](size_t i) const{
+        return buffer+i*rowStride;
+    }
+    T* row(size_t i){
+        return buffer+i*rowStride;
+    }
+    const T* row(size_t i) const{
+        return buffer+i*rowStride;
+    }
+    T* data(){
+        return buffer;
+    }
+    const T* data() const{
+        return buffer;
+    }
+    size_t rows() const{
+        return nrows;
+    }
+    size_t cols() const{
+        return ncols;
+    }
+    // elements between the starts of two rows, cols rounded up to the alignment
+    size_t stride() const{
+        return rowStride;
+    }
+    bool empty() const{
+        return buffer==NULL;
+    }
+    void fill(T value){
+        for(size_t i=0;i<nrows;i++){
+            T* r = row(i);
+            for(size_t j=0;j<ncols;j++){
+                r[j] = value;
+            }
+        }
+    }
+    // drop the storage now instead of waiting for the destructor
+    void release(){
+        if(buffer){
+#ifdef _WIN32
+            _aligned_free(buffer);
+#else
+            free(buffer);
+#endif
+        }
+        buffer = NULL;
+        nrows = 0;
+        ncols = 0;
+        rowStride = 0;
+        bytes = 0;
+    }
+private:
+    T* buffer;
+    size_t nrows;
+    size_t ncols;
+    size_t rowStride;
+    size_t bytes;
+
+    void allocate(size_t rows, size_t cols, bool hugePages){
+        size_t perLine = MATRIX_ALIGN/sizeof(T);
+        nrows = rows;
+        ncols = cols;
+        rowStride = (cols+perLine-1)/perLine*perLine;
+        bytes = rows*rowStride*sizeof(T);
+        if(bytes==0){
+            buffer = NULL;
+            return;
+        }
+        // not worth a 2MB aligned block for small matrices
+        hugePages = hugePages && bytes>=MATRIX_HUGE_PAGE;
+        void* p = NULL;
+#ifdef _WIN32
+        (void)hugePages;
+        p = _aligned_malloc(bytes, MATRIX_ALIGN);
+#else
+        size_t alignment = hugePages ? MATRIX_HUGE_PAGE : MATRIX_ALIGN;
+        if(posix_memalign(&p, alignment, bytes)!=0){
+            p = NULL;
+        }
+#ifdef MADV_HUGEPAGE
+        // transparent huge pages, a hint only so failure is ignored
+        if(p && hugePages){
+            madvise(p, bytes, MADV_HUGEPAGE);
+        }
+#endif
+#endif
+        if(!p){
+            throw bad_alloc();
+        }
+        buffer = static_cast<T*>(p);
+    }
+    void take(Matrix& other){
+        buffer = other.buffer;
+        nrows = other.nrows;
+        ncols = other.ncols;
+        rowStride = other.rowStride;
+        bytes = other.bytes;
+        other.buffer = NULL;
+        other.nrows = 0;
+        other.ncols = 0;
+        other.rowStride = 0;
+        other.bytes = 0;
+    }
+};
+#endif
@@ -0,0 +1,150 @@
+#ifndef MEMBERSHIP_H
+#define MEMBERSHIP_H
+#include <cstddef>
+#include <limits>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define MEMBERSHIP_X86_SIMD
+#include <immintrin.h>
+#endif
+using namespace std;
+// fuzzy memberships of faces [begin,end) from the distance rows of the typen seeds:
+// probs[j][i] = (1/rows[j][i]) / sum_l 1/rows[l][i], labels[i] the first patch with the
+// largest 1/rows (0 if none is positive); a face at distance 0 from a seed belongs to it
+// alone. rows and probs are typen rows of contiguous floats
+typedef void (*MembershipKernel)(const float* const* rows, unsigned int typen, size_t begin, size_t end, float* const* probs, unsigned short* labels);
+// the reciprocals are computed once and kept in probs until the total is known; the
+// sums run over the patches in order like the scalar loop, so every version gives the
+// same bits, one version per instruction set
+class MembershipKernels{
+public:
+    static void scalar(const float* const* rows, unsigned int typen, size_t begin, size_t end, float* const* probs, unsigned short* labels){
+        for(size_t i=begin;i<end;i++){
+            float total = 0;
+            float best = 0;
+            unsigned int label = 0;
+            for(unsigned int j=0;j<typen;j++){
+                float r = 1/rows[j][i];
+                probs[j][i] = r;
+                total += r;
+                if(r>best){
+                    best = r;
+                    label = j;
+                }
+            }
+            bool seed = best==numeric_limits<float>::infinity();
+            for(unsigned int j=0;j<typen;j++){
+                probs[j][i] = seed ? (j==label) : probs[j][i]/total;
+            }
+            labels[i] = label;
+        }
+    }
+#ifdef MEMBERSHIP_X86_SIMD
+    __attribute__((target("sse4.1")))
+    static void sse4(const float* const* rows, unsigned int typen, size_t begin, size_t end, float* const* probs, unsigned short* labels){
+        size_t i = begin;
+        const __m128 one = _mm_set1_ps(1);
+        const __m128 inf = _mm_set1_ps(numeric_limits<float>::infinity());
+        for(;i+4<=end;i+=4){
+            __m128 total = _mm_setzero_ps();
+            __m128 best = _mm_setzero_ps();
+            __m128i label = _mm_setzero_si128();
+            for(unsigned int j=0;j<typen;j++){
+                __m128 r = _mm_div_ps(one, _mm_loadu_ps(rows[j]+i));
+                _mm_storeu_ps(probs[j]+i, r);
+                total = _mm_add_ps(total, r);
+                __m128 larger = _mm_cmpgt_ps(r, best);
+                best = _mm_blendv_ps(best, r, larger);
+                label = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(label), _mm_castsi128_ps(_mm_set1_epi32(j)), larger));
+            }
+            __m128 seed = _mm_cmpeq_ps(best, inf);
+            for(unsigned int j=0;j<typen;j++){
+                __m128 p = _mm_div_ps(_mm_loadu_ps(probs[j]+i), total);
+                __m128 own = _mm_and_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(label, _mm_set1_epi32(j))), one);
+                _mm_storeu_ps(probs[j]+i, _mm_blendv_ps(p, own, seed));
+            }
+            _mm_storel_epi64((__m128i*)(labels+i), _mm_packus_epi32(label, label));
+        }
+        scalar(rows, typen, i, end, probs, labels);
+    }
+    __attribute__((target("avx2")))
+    static void avx2(const float* const* rows, unsigned int typen, size_t begin, size_t end, float* const* probs, unsigned short* labels){
+        size_t i = begin;
+        const __m256 one = _mm256_set1_ps(1);
+        const __m256 inf = _mm256_set1_ps(numeric_limits<float>::infinity());
+        for(;i+8<=end;i+=8){
+            __m256 total = _mm256_setzero_ps();
+            __m256 best = _mm256_setzero_ps();
+            __m256i label = _mm256_setzero_si256();
+            for(unsigned int j=0;j<typen;j++){
+                __m256 r = _mm256_div_ps(one, _mm256_loadu_ps(rows[j]+i));
+                _mm256_storeu_ps(probs[j]+i, r);
+                total = _mm256_add_ps(total, r);
+                __m256 larger = _mm256_cmp_ps(r, best, _CMP_GT_OQ);
+                best = _mm256_blendv_ps(best, r, larger);
+                label = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(label), _mm256_castsi256_ps(_mm256_set1_epi32(j)), larger));
+            }
+            __m256 seed = _mm256_cmp_ps(best, inf, _CMP_EQ_OQ);
+            for(unsigned int j=0;j<typen;j++){
+                __m256 p = _mm256_div_ps(_mm256_loadu_ps(probs[j]+i), total);
+                __m256 own = _mm256_and_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(label, _mm256_set1_epi32(j))), one);
+                _mm256_storeu_ps(probs[j]+i, _mm256_blendv_ps(p, own, seed));
+            }
+            __m128i packed = _mm_packus_epi32(_mm256_castsi256_si128(label), _mm256_extracti128_si256(label, 1));
+            _mm_storeu_si128((__m128i*)(labels+i), packed);
+        }
+        scalar(rows, typen, i, end, probs, labels);
+    }
+// gcc 12 warns about the undefined passthrough operand inside _mm512_cvtepi32_epi16
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+    __attribute__((target("avx512f")))
+    static void avx512(const float* const* rows, unsigned int typen, size_t begin, size_t end, float* const* probs, unsigned short* labels){
+        size_t i = begin;
+        const __m512 one = _mm512_set1_ps(1);
+        const __m512 inf = _mm512_set1_ps(numeric_limits<float>::infinity());
+        for(;i+16<=end;i+=16){
+            __m512 total = _mm512_setzero_ps();
+            __m512 best = _mm512_setzero_ps();
+            __m512i label = _mm512_setzero_si512();
+            for(unsigned int j=0;j<typen;j++){
+                __m512 r = _mm512_div_ps(one, _mm512_loadu_ps(rows[j]+i));
+                _mm512_storeu_ps(probs[j]+i, r);
+                total = _mm512_add_ps(total, r);
+                __mmask16 larger = _mm512_cmp_ps_mask(r, best, _CMP_GT_OQ);
+                best = _mm512_mask_blend_ps(larger, best, r);
+                label = _mm512_mask_blend_epi32(larger, label, _mm512_set1_epi32(j));
+            }
+            __mmask16 seed = _mm512_cmp_ps_mask(best, inf, _CMP_EQ_OQ);
+            for(unsigned int j=0;j<typen;j++){
+                __m512 p = _mm512_div_ps(_mm512_loadu_ps(probs[j]+i), total);
+                __mmask16 own = _mm512_cmpeq_epi32_mask(label, _mm512_set1_epi32(j));
+                __m512 hot = _mm512_maskz_mov_ps(own, one);
+                _mm512_storeu_ps(probs[j]+i, _mm512_mask_blend_ps(seed, p, hot));
+            }
+            _mm256_storeu_si256((__m256i*)(labels+i), _mm512_cvtepi32_epi16(label));
+        }
+        scalar(rows, typen, i, end, probs, labels);
+    }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+    // picked once from the running cpu
+    static MembershipKernel select(){
+#ifdef MEMBERSHIP_X86_SIMD
+        if(__builtin_cpu_supports("avx512f")){
+            return avx512;
+        }
+        if(__builtin_cpu_supports("avx2")){
+            return avx2;
+        }
+        if(__builtin_cpu_supports("sse4.1")){
+            return sse4;
+        }
+#endif
+        return scalar;
+    }
+};
+#endif
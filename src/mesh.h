@@ -3,18 +3,34 @@
 #ifndef MESH_H
 #define MESH_H
 
-#include <glad/glad.h> // holds all OpenGL type declarations
-
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#include "shader.h"
 #include "decomposition.h"
 #include "netflow.h"
+#include "flowgraph.h"
+#include "bkflow.h"
+#include "pushrelabel.h"
+#include "dinic.h"
+#include "dimacs.h"
+#include "fuzzysweep.h"
+#include "expansion.h"
+#include "representative.h"
+#include "membership.h"
+#include "topmembership.h"
+#include "seeding.h"
+#include "matrix.h"
+#include "dualgraph.h"
+#include "dualbuilder.h"
+#include "profiler.h"
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
 using namespace std;
 
 #define MAX_BONE_INFLUENCE 4
@@ -37,16 +53,6 @@ struct Vertex {
 	//weights from each bone
 	float m_Weights[MAX_BONE_INFLUENCE];
 };
-struct Edge {
-    // face indice of left and right
-    unsigned int left;
-    unsigned int right;
-    // vertice indice of left and right
-    unsigned int leftv;
-    unsigned int rightv;
-    float ang_d;
-    float geo_d;
-};
 struct Face {
     glm::vec3 Normal;
     unsigned int type;
@@ -64,100 +70,117 @@ public:
     vector<Face> faces;
     vector<unsigned int> indices;
     vector<Texture>      textures;
-    unsigned int VAO;
-    // edge map to face; distance of faces
-    vector<map<unsigned int, Edge>>* edge2face;
-    // face map to edge; used for 最小割
-    int** face2edgeb;
-    int** face2edgee;
-    float** face2edgew;
-    float ** weights;
-    int** paths;
+    // face adjacency with per edge attributes; used for 最小割 and dijkstra
+    DualGraph dual;
+    // edges that are not shared by exactly two faces
+    DualReport dualReport;
+    Matrix<float> weights;
+    Matrix<int> paths;
+    // sparse distance mode: the cached rows of the seeds
+    DistanceMode distanceMode = SPARSE_DIJKSTRA;
+    map<unsigned int, vector<float>> distanceRows;
+    vector<float> scratchRow;
     float sum_angD, sum_geoD;
-    float** probs;
-    int * typeindex;
+    Matrix<float> probs;
+    // more patches than denseMemberships keep the membershipSlots largest memberships of
+    // every face in topProbs instead, and probs is empty
+    unsigned int denseMemberships = 8;
+    unsigned int membershipSlots = 4;
+    TopMemberships topProbs;
+    // the most probable patch of every face, as in faces[i].type
+    vector<unsigned short> labels;
+    vector<int> typeindex;
+    // patches of simpleDecomposition, 0 picks the count with the best bend of the cost
+    // from 2 to maxPatches
+    unsigned int patches = 2;
+    unsigned int maxPatches = 10;
+    // two way seeds; sparse mode has no matrix to scan and always sweeps
+    SeedMode seedMode = FARTHEST_PAIR;
     float avgAng_d;
     float avgGeo_d;
-    // fuzzy matrix
-    float** fuzzycap;
+    // max flow engine of the fuzzy region cut
+    MaxFlowSolver flowSolver = BOYKOV_KOLMOGOROV;
+    // integer capacities: the fuzzy capacities times capacityScale, rounded
+    CapacityMode capacityMode = FLOAT_CAPACITY;
+    double capacityScale = 65536;
+    // kept between fuzzy calls: each fuzzy() rebuilds the graph from fuzzyEdges, only
+    // the vectors' storage and the solver's node arrays are reused
+    BoykovKolmogorov flowWorkspace;
+    // fuzzy region graph: A, C, B faces then the source and the sink, one FlowEdge per
+    // dual edge with a fuzzy face, linear in the region instead of the dense matrix
+    unsigned int fuzzyNodes = 0;
+    vector<FlowEdge> fuzzyEdges;
+    // face to its fuzzy node, -1 between fuzzyConstruct calls
+    vector<int> localIndex;
     vector<int> C;
     vector<int> A;
     vector<int> B;
     vector<int> total;
     Decomposition decompositionMachine = Decomposition(0.2,1.0);
     void initWeights(){
+        ScopedPhase phase("initWeights");
         unsigned int N = this->faces.size();
-        weights = new float*[N];
-        paths = new int*[N];
-        face2edgeb = new int*[N];
-        face2edgee = new int*[N];
-        face2edgew = new float*[N];
-        for(unsigned int i=0;i<N;i++){
-            weights[i] = new float[N];
-            paths[i] = new int[N];
-            face2edgeb[i] = new int[N];
-            face2edgee[i] = new int[N];
-            face2edgew[i] = new float[N];
+        bool dense = distanceMode!=SPARSE_DIJKSTRA;
+        if(dense){
+            weights = Matrix<float>(N, N, true);
+            paths = Matrix<int>(N, N, true);
+            weights.fill(-1);
+            for(unsigned int i=0;i<N;i++){
+                weights[i][i] = 0;
+                for(unsigned int j=0;j<N;j++){
+                    paths[i][j] = j;
+                }
+            }
+        }else{
+            weights.release();
+            paths.release();
+            scratchRow.resize(N);
         }
         sum_angD = 0;
         sum_geoD = 0;
-        for(unsigned int i=0;i<N;i++){
-            this->weights[i][i] = 0;
-            paths[i][i] = i;
-            face2edgeb[i][i] = -1;
-            face2edgee[i][i] = -1;
-            for(unsigned int j=i+1;j<N;j++){
-                this->weights[i][j] = -1;
-                this->weights[j][i] = -1;
-                this->paths[i][j] = j;
-                this->paths[j][i] = i;
-                face2edgeb[i][j] = -1;
-                face2edgeb[j][i] = -1;
-                face2edgee[i][j] = -1;
-                face2edgee[j][i] = -1;
-                face2edgew[i][j] = -1;
-                face2edgew[j][i] = -1;
-            }
-        }
         avgAng_d = 0;
         avgGeo_d = 0;
         int adjacentN = 0;
-        for(unsigned int i=0;i<edge2face->size();i++){
-            for(map<unsigned int, Edge>::iterator it=edge2face->at(i).begin();it != edge2face->at(i).end();it++){
-                unsigned int j = it->first;
-                unsigned int left = it->second.left;
-                unsigned int right = it->second.right;
-                unsigned int leftv = it->second.leftv;
-                unsigned int rightv = it->second.rightv;
-                it->second.ang_d = decompositionMachine.calcAngDistance(faces[left].Normal,faces[right].Normal,vertices[i].Position,vertices[j].Position,vertices[left].Position,vertices[right].Position);
-                it->second.geo_d = decompositionMachine.calcGeoDistance(vertices[i].Position,vertices[j].Position,vertices[leftv].Position,vertices[rightv].Position);
-                avgAng_d += it->second.ang_d;
-                avgGeo_d += it->second.geo_d;
-                adjacentN += 1;
-
-                face2edgeb[left][right] = leftv;
-                face2edgee[left][right] = rightv;
-                face2edgeb[right][left] = leftv;
-                face2edgee[right][left] = rightv;
-                face2edgew[left][right] = it->second.ang_d;
-                face2edgew[right][left] = it->second.ang_d;
+        unsigned int E = dual.edgeCount();
+        EdgeBatch batch;
+        batch.resize(E);
+        ThreadPool::global().parallelFor(0, E, 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int e=begin;e<end;e++){
+                batch.set(e, vertices[dual.begin[e]].Position, vertices[dual.end[e]].Position, vertices[dual.leftv[e]].Position, vertices[dual.rightv[e]].Position, faces[dual.left[e]].Normal, faces[dual.right[e]].Normal);
             }
+        });
+        decompositionMachine.calcDistances(batch, dual.angDistance.data(), dual.geoDistance.data());
+        for(unsigned int e=0;e<E;e++){
+            avgAng_d += dual.angDistance[e];
+            avgGeo_d += dual.geoDistance[e];
+            adjacentN += 1;
         }
         avgAng_d /= adjacentN;
         avgGeo_d /= adjacentN;
         float delta = 0.5;
-        for(unsigned int i=0;i<edge2face->size();i++){
-            for(map<unsigned int, Edge>::iterator it=edge2face->at(i).begin();it != edge2face->at(i).end();it++){
-                unsigned int left = it->second.left;
-                unsigned int right = it->second.right;
-                weights[left][right] = (1-delta)*it->second.ang_d/avgAng_d+delta*it->second.geo_d/avgGeo_d;
-                weights[right][left] = weights[left][right];
+        for(unsigned int e=0;e<dual.edgeCount();e++){
+            unsigned int left = dual.left[e];
+            unsigned int right = dual.right[e];
+            float w = (1-delta)*dual.angDistance[e]/avgAng_d+delta*dual.geoDistance[e]/avgGeo_d;
+            dual.weights[e] = w;
+            if(dense){
+                weights[left][right] = w;
+                weights[right][left] = w;
             }
         }
     }
     void calcWeights(){
-        unsigned int N = this->faces.size();
-        decompositionMachine.floyd(weights, paths, N);
+        // sparse mode never builds the matrix, rows are computed in distanceRow
+        if(distanceMode==SPARSE_DIJKSTRA){
+            return;
+        }
+        if(distanceMode==DENSE_FLOYD){
+            ScopedPhase phase("floyd");
+            decompositionMachine.floyd(weights, paths);
+        }else{
+            ScopedPhase phase("dijkstraAll");
+            decompositionMachine.dijkstraAll(dual, weights, paths);
+        }
         // for(unsigned int i=0;i<N;i++){
         //     for(unsigned int j=0;j<N;j++){
         //         cout<<weights[i][j]<<";"<<paths[i][j]<<",";
@@ -165,6 +188,36 @@ public:
         //     cout<<endl;
         // }
     }
+    // distances from face to all faces, the row of the floyd matrix in dense mode
+    const float* distanceRow(unsigned int face){
+        if(distanceMode!=SPARSE_DIJKSTRA){
+            return weights[face];
+        }
+        map<unsigned int, vector<float>>::iterator it = distanceRows.find(face);
+        if(it==distanceRows.end()){
+            it = distanceRows.insert(make_pair(face, vector<float>(faces.size()))).first;
+            decompositionMachine.dijkstra(dual, face, it->second.data());
+            Profiler::global().count("dijkstra_rows");
+        }
+        return it->second.data();
+    }
+    // drop cached rows of faces which are no longer seeds
+    void releaseRows(unsigned int typen){
+        map<unsigned int, vector<float>>::iterator it = distanceRows.begin();
+        while(it!=distanceRows.end()){
+            bool seed = false;
+            for(unsigned int j=0;j<typen;j++){
+                if(typeindex[j]==(int)it->first){
+                    seed = true;
+                }
+            }
+            if(seed){
+                it++;
+            }else{
+                distanceRows.erase(it++);
+            }
+        }
+    }
     // constructor
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, vector<Face> faces)
     {
@@ -172,129 +225,178 @@ public:
         this->indices = indices;
         this->textures = textures;
         this->faces = faces;
-
-        // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader &shader) 
-    {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to string
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to string
-             else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to string
-
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
-
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
-    }
-    void initProbs(unsigned int typen=2){
+    // seeds and probs of typen patches, 0 picks the number of patches from 2..maxPatches;
+    // returns the number of patches
+    unsigned int initProbs(unsigned int typen=2){
+        ScopedPhase phase("initProbs");
         unsigned int N = this->faces.size();
-        int maxi=0;
-        int maxj = 0;
-        float length =0;
-        probs = new float*[typen];
-        for(unsigned int i=0;i<typen;i++){
-            probs[i] = new float[N];
-        }
-        for(unsigned int i=0;i<N;i++){
-            for(unsigned int j=i;j<N;j++){
-                if(weights[i][j]>length){
-                    length = weights[i][j];
-                    maxi = i;
-                    maxj = j;
+        if(typen==2){
+            int maxi=0;
+            int maxj = 0;
+            float length =0;
+            if(distanceMode!=SPARSE_DIJKSTRA && seedMode==FARTHEST_PAIR){
+                for(unsigned int i=0;i<N;i++){
+                    for(unsigned int j=i;j<N;j++){
+                        if(weights[i][j]>length){
+                            length = weights[i][j];
+                            maxi = i;
+                            maxj = j;
+                        }
+                    }
                 }
+                Profiler::global().set("seed_sweeps", 0);
+            }else{
+                // no matrix to scan, or not worth N*N/2 reads: sweep from face 0
+                DoubleSweep sweep;
+                pair<unsigned int, unsigned int> ends = sweep.run(N, 0, [&](unsigned int face){
+                    return distanceRow(face);
+                });
+                maxi = ends.first;
+                maxj = ends.second;
+                length = sweep.distance;
+                Profiler::global().set("seed_sweeps", sweep.sweeps);
             }
-        }
-        typeindex = new int[typen];
-        typeindex[0] = maxi;
-        typeindex[1] = maxj;
-        // cout<<maxi<<" "<<maxj<<endl;
-        for(unsigned int i=0;i<N;i++){
-            float probsi_total =0;
-            int maxtype = 0;
-            float maxprob = 0;
-            for(unsigned int j=0;j<typen;j++){
-                probsi_total += 1/weights[typeindex[j]][i];
-                if((1/weights[typeindex[j]][i])>maxprob){
-                    maxprob = 1/weights[typeindex[j]][i];
-                    maxtype = j;
+            Profiler::global().label("seed_distance", to_string(length));
+            typeindex.assign(typen, 0);
+            typeindex[0] = maxi;
+            typeindex[1] = maxj;
+            // cout<<maxi<<" "<<maxj<<endl;
+            // the rows of the sweeps that did not end at a seed
+            releaseRows(typen);
+        }else{
+            // farthest point seeds from the farthest face of face 0, one row per seed; for
+            // the automatic count one seed more than maxPatches so the last k has a bend
+            unsigned int count = typen ? typen : max(3u, maxPatches+1);
+            FarthestPointSeeds sampling;
+            unsigned int first = decompositionMachine.farthest(distanceRow(0), N);
+            vector<unsigned int> seeds = sampling.pick(N, first, count, [&](unsigned int face){
+                return distanceRow(face);
+            });
+            typeindex.assign(seeds.begin(), seeds.end());
+            if(typen==0 && seeds.size()>=3){
+                vector<const float*> rows(seeds.size());
+                for(unsigned int j=0;j<seeds.size();j++){
+                    rows[j] = distanceRow(seeds[j]);
                 }
+                typeindex.resize(FarthestPointSeeds::elbow(FarthestPointSeeds::costs(rows, N)));
             }
-            faces[i].type = maxtype;
-            for(unsigned int j=0;j<typen;j++){
-                probs[j][i] = 1/weights[typeindex[j]][i]/probsi_total;
-                // cout<< weights[typeindex[j]][i]<<" ";
-            }
-            // cout<<maxtype<<endl;
+            typen = typeindex.size();
+            // the row of face 0, and the seeds the automatic count dropped
+            releaseRows(typen);
+            Profiler::global().set("patches", typen);
+        }
+        if(typen<=denseMemberships){
+            probs = Matrix<float>(typen, N);
+            topProbs.release();
+        }else{
+            probs.release();
         }
+        memberships(probs, typen);
+        return typen;
+    }
+    void prob(Matrix<float>& probs,unsigned int typen){
+        memberships(probs, typen);
     }
-    void prob(float** probs,unsigned int typen){
+    // probs and labels of every face from the rows of the seeds, faces[i].type follows
+    // labels; one pass over the contiguous rows, blocks of faces spread over the pool.
+    // With more than denseMemberships patches the kernel writes a small block at a time
+    // and only the top slots of each face are kept in topProbs
+    void memberships(Matrix<float>& probs, unsigned int typen){
+        static MembershipKernel kernel = MembershipKernels::select();
         unsigned int N = this->faces.size();
-        for(unsigned int i=0;i<N;i++){
-            float probsi_total =0;
-            int maxtype = 0;
-            float maxprob = 0;
+        vector<const float*> rows(typen);
+        for(unsigned int j=0;j<typen;j++){
+            rows[j] = distanceRow(typeindex[j]);
+        }
+        labels.resize(N);
+        // the seed rows stay cached in sparse mode, patchRow recomputes from them; dense
+        // modes read them from the matrix
+        Profiler::global().set("seed_row_bytes", distanceMode==SPARSE_DIJKSTRA ? (long long)typen*N*sizeof(float) : 0);
+        if(typen<=denseMemberships){
+            vector<float*> out(typen);
             for(unsigned int j=0;j<typen;j++){
-                probsi_total += 1/weights[typeindex[j]][i];
-                if((1/weights[typeindex[j]][i])>maxprob){
-                    maxprob = 1/weights[typeindex[j]][i];
-                    maxtype = j;
+                out[j] = probs[j];
+            }
+            ThreadPool::global().parallelFor(0, N, 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+                kernel(rows.data(), typen, begin, end, out.data(), labels.data());
+                for(unsigned int i=begin;i<end;i++){
+                    faces[i].type = labels[i];
                 }
+            });
+            Profiler::global().set("membership_bytes", (long long)typen*N*sizeof(float));
+            return;
+        }
+        topProbs.resize(typen, N, membershipSlots);
+        ThreadPool::global().parallelFor(0, N, 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+            const unsigned int block = 256;
+            vector<float> scratch((size_t)typen*block);
+            vector<const float*> in(typen);
+            vector<float*> out(typen);
+            for(unsigned int start=begin;start<end;start+=block){
+                unsigned int stop = min(end, start+block);
+                for(unsigned int j=0;j<typen;j++){
+                    in[j] = rows[j]+start;
+                    out[j] = &scratch[(size_t)j*block];
+                }
+                kernel(in.data(), typen, 0, stop-start, out.data(), labels.data()+start);
+                topProbs.store(start, stop, in.data(), out.data());
             }
-            faces[i].type = maxtype;
-            for(unsigned int j=0;j<typen;j++){
-                probs[j][i] = 1/weights[typeindex[j]][i]/probsi_total;
-                // cout<< weights[typeindex[j]][i]<<" ";
+            for(unsigned int i=begin;i<end;i++){
+                faces[i].type = labels[i];
             }
-            // cout<<maxtype<<endl;
+        });
+        Profiler::global().set("membership_bytes", topProbs.bytes());
+    }
+    // the membership of patch j for every face: probs[j], or recomputed into buffer from
+    // topProbs and the row of the seed, the same values either way
+    const float* patchRow(unsigned int j, vector<float>& buffer){
+        if(topProbs.empty()){
+            return probs[j];
         }
+        buffer.resize(faces.size());
+        topProbs.row(j, distanceRow(typeindex[j]), buffer.data());
+        return buffer.data();
     }
-    void rep(float** probs, unsigned int typen, unsigned int times=0){
+    void rep(Matrix<float>& probs, unsigned int typen, unsigned int times=0){
+        ScopedPhase phase("rep");
         unsigned int N = this->faces.size();
         float delta = 0.2;
-        unsigned int* tmptypeindex= new unsigned int[typen];
-        float* tmpweights= new float[typen];
+        vector<unsigned int> tmptypeindex(typen);
+        vector<float> patch;
+        RepresentativeSearch search;
+        // seed rows come from the cache, candidates are not cached, otherwise sparse mode
+        // would grow back to N*N; called from the pool threads, which only read the cache
+        auto row = [&](unsigned int face, float* buffer) -> const float*{
+            if(distanceMode!=SPARSE_DIJKSTRA){
+                return weights[face];
+            }
+            map<unsigned int, vector<float>>::const_iterator it = distanceRows.find(face);
+            if(it!=distanceRows.end()){
+                return it->second.data();
+            }
+            decompositionMachine.dijkstra(dual, face, buffer);
+            return buffer;
+        };
+        // seed sets seen so far: k way memberships, and faces no seed reaches, can send
+        // the seeds round in a cycle, stop when one comes back
+        set<vector<int>> visited;
+        visited.insert(typeindex);
         // move the seed
         for(unsigned int t=0;t<1000;t++){
+            Profiler::global().count("rep_iterations");
             for(unsigned int j=0;j<typen;j++){
-                tmptypeindex[j] = typeindex[j];
-                tmpweights[j] = 1e10;
-                for(unsigned int i=0;i<N;i++){
-                    if(probs[j][i]>0.5+delta){
-                        float w = weightsProb(i,j);
-                        if(w<tmpweights[j]){
-                            tmpweights[j] = w;
-                            tmptypeindex[j] = i;
-                        }
-                    }
-                }
+                const float* p = patchRow(j, patch);
+                const float* seedRow = distanceRow(typeindex[j]);
+                // two patches: the confident faces. k memberships spread over k patches and
+                // rarely reach 0.5+delta, so there the faces labelled j are the candidates.
+                // Either way only faces the seed reaches, a seed stays on its part of a
+                // mesh that is not connected
+                auto candidate = [&](unsigned int i){
+                    return seedRow[i]>=0 && (typen==2 ? p[i]>0.5+delta : labels[i]==j);
+                };
+                tmptypeindex[j] = search.search(p, N, candidate, typeindex[j], row);
             }
             unsigned int difference = 0;
             for(unsigned int j=0;j<typen;j++){
@@ -304,139 +406,309 @@ public:
                 }
             }
             if(difference>0){
+                releaseRows(typen);
                 prob(probs,typen);
             }else{
                 break;
             }
+            if(!visited.insert(typeindex).second){
+                Profiler::global().set("rep_cycle", 1);
+                break;
+            }
         }
+        Profiler::global().set("rep_candidates", search.candidates);
+        Profiler::global().set("rep_landmark_rows", search.landmarkRows);
+        Profiler::global().set("rep_exact_rows", search.exactRows);
+        Profiler::global().set("rep_certified", search.certified);
         if(times==1000){
             cout<<"iteration limited"<<endl;
             return;
         }
     }
-    float weightsProb(unsigned int facei, unsigned int typei){
-        unsigned int N = this->faces.size();
-        float w = 0;
-        for(unsigned int i=0;i<N;i++){
-            w += probs[typei][i]*weights[facei][i];
-        }
-        return w;
-    }
     void fuzzyConstruct(float delta=0.1){
+        ScopedPhase phase("fuzzyConstruct");
         unsigned int N = this->faces.size();
-        set<unsigned int> As;
-        set<unsigned int> Bs;
-        
+        vector<unsigned int> As;
+        vector<unsigned int> Bs;
+        C.clear();
+        A.clear();
+        B.clear();
+        total.clear();
+        vector<float> buffer;
+        const float* p0 = patchRow(0, buffer);
+
         for(unsigned int i=0;i<N;i++){
-            if(probs[0][i]>(0.5-delta)&&probs[0][i]<(0.5+delta)){
+            if(p0[i]>(0.5-delta)&&p0[i]<(0.5+delta)){
                 C.push_back(i);
-                for(unsigned int j=0;j<3;j++){
-                    unsigned int begin = indices[i*3+j];
-                    unsigned int end = indices[i*3+(j+1)%3];
-                    bool findleft = true;
-                    if (begin>end){
-                        begin,end = end, begin;
-                        findleft = false;
-                    }
-                    unsigned int left;
-                    if(edge2face->at(begin).count(end)>0){
-                        if(findleft){
-                            left = edge2face->at(begin)[end].left;
-                        }else{
-                            left = edge2face->at(begin)[end].right;
-                        }
-                        if(probs[0][left]>0.5+delta){
-                            As.insert(left);
-                        }else if(probs[0][left]<0.5-delta){
-                            Bs.insert(left);
-                        }
+                for(unsigned int k=0;k<dual.degree(i);k++){
+                    unsigned int n = dual.neighbour(i, k);
+                    if(p0[n]>0.5+delta){
+                        As.push_back(n);
+                    }else if(p0[n]<0.5-delta){
+                        Bs.push_back(n);
                     }
                 }
             }
         }
-        
-        for(set<unsigned int>::iterator it=As.begin();it!=As.end();it++){
-            A.push_back(*it);
-            total.push_back(*it);
+        sort(As.begin(), As.end());
+        As.erase(unique(As.begin(), As.end()), As.end());
+        sort(Bs.begin(), Bs.end());
+        Bs.erase(unique(Bs.begin(), Bs.end()), Bs.end());
+        for(unsigned int j=0;j<As.size();j++){
+            A.push_back(As[j]);
+            total.push_back(As[j]);
         }
         for(unsigned int j=0;j<C.size();j++){
             total.push_back(C.at(j));
         }
-        for(set<unsigned int>::iterator it=Bs.begin();it!=Bs.end();it++){
-            B.push_back(*it);
-            total.push_back(*it);
+        for(unsigned int j=0;j<Bs.size();j++){
+            B.push_back(Bs[j]);
+            total.push_back(Bs[j]);
         }
         // -1,-2 is the no of src and dst, index is -2,-1
         total.push_back(-1);
         total.push_back(-2);
+        Profiler::global().set("fuzzy_a", A.size());
+        Profiler::global().set("fuzzy_b", B.size());
+        Profiler::global().set("fuzzy_c", C.size());
 
-        int fuzzysize = A.size()+B.size()+C.size()+2;
-        fuzzycap = new float*[fuzzysize];
-        for(unsigned int i=0;i<fuzzysize;i++){
-            fuzzycap[i] = new float[fuzzysize];
-            for(unsigned int j=0;j<fuzzysize;j++){
-                fuzzycap[i][j] = -1;
-            }
+        // face index to its node, A then C then B like total, reset before returning so
+        // the construction stays O(|A|+|B|+|C|)
+        localIndex.resize(N, -1);
+        for(unsigned int i=0;i<total.size()-2;i++){
+            localIndex[total.at(i)] = i;
         }
-        int Aoffset = 0 ;
-        for(unsigned int i=0;i<(A.size());i++){
-            // 0 is the source
-            fuzzycap[fuzzysize-2][i+Aoffset] = 1e10;
-            fuzzycap[i+Aoffset][fuzzysize-2] = 1e10;
-            for(unsigned int j=0;j<C.size();j++){
-                if(face2edgeb[A.at(i)][C.at(j)]!=-1){
-                    fuzzycap[i+Aoffset][A.size()+Aoffset+j] = 1/(1+face2edgew[A.at(i)][C.at(j)]/avgAng_d);
-                    fuzzycap[A.size()+Aoffset+j][i+Aoffset] = fuzzycap[i+Aoffset][A.size()+Aoffset+j];
-                }
-            }
+        fuzzyNodes = A.size()+B.size()+C.size()+2;
+        unsigned int source = fuzzyNodes-2;
+        unsigned int sink = fuzzyNodes-1;
+        fuzzyEdges.clear();
+        for(unsigned int i=0;i<A.size();i++){
+            addFuzzyEdge(source, i, 1e10);
         }
-        unsigned int Coffset = A.size()+Aoffset;
+        unsigned int Coffset = A.size();
         unsigned int Boffset = Coffset+C.size();
-        for(unsigned int i=0;i<(B.size());i++){
-            // fuzzysize-1 is the dst
-            fuzzycap[fuzzysize-1][Boffset+i] = 1e10;
-            fuzzycap[Boffset+i][fuzzysize-1] = 1e10;
-            for(unsigned int j=0;j<C.size();j++){
-                if(face2edgeb[B.at(i)][C.at(j)]!=-1){
-                    fuzzycap[Boffset+i][Coffset+j] = 1/(1+face2edgew[B.at(i)][C.at(j)]/avgAng_d);
-                    fuzzycap[Coffset+j][Boffset+i] = fuzzycap[Boffset+i][Coffset+j];
-                }
-            }
+        for(unsigned int i=0;i<B.size();i++){
+            addFuzzyEdge(Boffset+i, sink, 1e10);
         }
+        // every edge with a fuzzy face on one side, A-C, C-C and C-B; a C-C edge is seen
+        // from both of its faces and added from the lower node only
         for(unsigned int i=0;i<C.size();i++){
-            for(unsigned int j=i+1;j<C.size();j++){
-                if(face2edgeb[C.at(i)][C.at(j)]!=-1){
-                    fuzzycap[Coffset+i][Coffset+j] = 1/(1+face2edgew[C.at(i)][C.at(j)]/avgAng_d);
-                    fuzzycap[Coffset+j][Coffset+i] = fuzzycap[Coffset+i][Coffset+j];
+            unsigned int face = C.at(i);
+            for(unsigned int k=0;k<dual.degree(face);k++){
+                int other = localIndex[dual.neighbour(face, k)];
+                if(other<0 || ((unsigned int)other>=Coffset && (unsigned int)other<Boffset && (unsigned int)other<Coffset+i)){
+                    continue;
                 }
+                float cap = fuzzyCapacity(dual.edge(face, k));
+                addFuzzyEdge(Coffset+i, other, cap);
             }
         }
+        // in node order, the arc order of the dense matrix this graph replaced
+        sort(fuzzyEdges.begin(), fuzzyEdges.end(), [](const FlowEdge& a, const FlowEdge& b){
+            return a.u<b.u || (a.u==b.u && a.v<b.v);
+        });
+        for(unsigned int i=0;i<total.size()-2;i++){
+            localIndex[total.at(i)] = -1;
+        }
+    }
+    // capacity of dual edge e in every fuzzy cut, small across concave edges
+    float fuzzyCapacity(unsigned int e) const{
+        return 1/(1+dual.angDistance[e]/avgAng_d);
+    }
+    vector<float> fuzzyCapacities() const{
+        vector<float> caps(dual.edgeCount());
+        for(unsigned int e=0;e<caps.size();e++){
+            caps[e] = fuzzyCapacity(e);
+        }
+        return caps;
+    }
+    // undirected edge of the fuzzy graph, stored with u<v
+    void addFuzzyEdge(unsigned int u, unsigned int v, float cap){
+        FlowEdge e;
+        e.u = min(u, v);
+        e.v = max(u, v);
+        e.cap = cap;
+        e.rcap = cap;
+        fuzzyEdges.push_back(e);
     }
     void fuzzy(){
         fuzzyConstruct(0.01); 
-        FordFulkerson gr = FordFulkerson(fuzzycap, A.size()+B.size()+C.size()+2);
-        gr.ff(A.size()+B.size()+C.size(),A.size()+B.size()+C.size()+1);
-        vector<int> cut = gr.cut(A.size()+B.size()+C.size(),A.size()+B.size()+C.size()+1);
-        for(int i=1;i<total.size()-1;i++){
+        vector<int> cut;
+        if(capacityMode!=FLOAT_CAPACITY && flowSolver!=FORD_FULKERSON){
+            cut = integerCut();
+        }else if(flowSolver==FORD_FULKERSON){
+            cut = minCut<FordFulkerson>();
+        }else if(flowSolver==PUSH_RELABEL){
+            cut = minCut<PushRelabel>();
+        }else if(flowSolver==PARALLEL_PUSH_RELABEL){
+            cut = minCut<ParallelPushRelabel>();
+        }else if(flowSolver==DINIC){
+            cut = minCut<Dinic>();
+        }else{
+            flowWorkspace.graph.build(fuzzyNodes, fuzzyEdges);
+            cut = minCut(flowWorkspace);
+        }
+        // the last two entries of total are the terminals, not faces
+        for(unsigned int i=0;i<total.size()-2;i++){
             faces[total.at(i)].type = 1;
         }
-        for(int i=0;i<cut.size();i++){
-            faces[total.at(cut.at(i))].type = 0;
+        for(unsigned int i=0;i<cut.size();i++){
+            if(total.at(cut.at(i))>=0){
+                faces[total.at(cut.at(i))].type = 0;
+            }
+        }
+    }
+    // the face types fuzzy would give for every delta, solved in one warm started sweep on
+    // integer capacities; faces outside a region keep their type from simpleDecomposition
+    vector<vector<unsigned int>> fuzzySweep(const vector<float>& deltas){
+        ScopedPhase phase("fuzzySweep");
+        vector<float> caps = fuzzyCapacities();
+        FuzzySweep sweep;
+        vector<float> buffer;
+        vector<vector<int>> sides = sweep.run(dual, patchRow(0, buffer), caps, capacityScale, deltas);
+        Profiler::global().set("sweep_warm_starts", sweep.warmStarts);
+        Profiler::global().set("sweep_cold_starts", sweep.coldStarts);
+        Profiler::global().set("augmenting_paths", sweep.augmentations);
+        vector<vector<unsigned int>> types(deltas.size());
+        for(unsigned int d=0;d<deltas.size();d++){
+            types[d].resize(faces.size());
+            for(unsigned int i=0;i<faces.size();i++){
+                types[d][i] = sides[d][i]<0 ? faces[i].type : sides[d][i];
+            }
+        }
+        return types;
+    }
+    // refines the boundaries between all typen patches at once by alpha expansion on
+    // integer capacities, starting from the types of simpleDecomposition; a face moves
+    // only if its two best probabilities are within 2*delta
+    void fuzzyExpansion(unsigned int typen, float delta=0.01){
+        ScopedPhase phase("fuzzyExpansion");
+        vector<float> caps = fuzzyCapacities();
+        vector<unsigned int> labels(faces.size());
+        for(unsigned int i=0;i<faces.size();i++){
+            labels[i] = faces[i].type;
+        }
+        AlphaExpansion expansion;
+        if(topProbs.empty()){
+            expansion.run(dual, DenseMemberships(probs, typen), caps, capacityScale, delta, labels);
+        }else{
+            expansion.run(dual, topProbs, caps, capacityScale, delta, labels);
         }
+        for(unsigned int i=0;i<faces.size();i++){
+            faces[i].type = labels[i];
+        }
+        Profiler::global().set("fuzzy_c", expansion.regionSize);
+        Profiler::global().set("expansions", expansion.expansions);
+        Profiler::global().set("expansions_accepted", expansion.accepted);
+        Profiler::global().set("expansion_cycles", expansion.cycles);
+        Profiler::global().set("expansion_energy", expansion.energy);
+        Profiler::global().set("augmenting_paths", expansion.augmentations);
+    }
+    // the csr solvers on quantised capacities, 64 bit when they do not fit in 32 bits
+    vector<int> integerCut(){
+        FlowGraph graph;
+        graph.build(fuzzyNodes, fuzzyEdges);
+        vector<int> cut;
+        if(capacityMode==INT32_CAPACITY){
+            if(integerCut<int>(graph, cut)){
+                return cut;
+            }
+            cout<<"fuzzy capacities overflow 32 bits, using 64"<<endl;
+            Profiler::global().label("capacity", "int64");
+        }
+        integerCut<long long>(graph, cut);
+        return cut;
+    }
+    template<typename Cap>
+    bool integerCut(const FlowGraph& graph, vector<int>& cut){
+        if(flowSolver==PUSH_RELABEL){
+            BasicPushRelabel<Cap> gr;
+            return quantizedCut(gr, graph, cut);
+        }
+        if(flowSolver==PARALLEL_PUSH_RELABEL){
+            BasicParallelPushRelabel<Cap> gr;
+            return quantizedCut(gr, graph, cut);
+        }
+        if(flowSolver==DINIC){
+            BasicDinic<Cap> gr;
+            gr.scaling = true;
+            return quantizedCut(gr, graph, cut);
+        }
+        BasicBoykovKolmogorov<Cap> gr;
+        return quantizedCut(gr, graph, cut);
+    }
+    template<typename Solver>
+    bool quantizedCut(Solver& gr, const FlowGraph& graph, vector<int>& cut){
+        int s = A.size()+B.size()+C.size();
+        {
+            ScopedPhase phase("quantize");
+            if(!gr.graph.quantize(graph, capacityScale, s, s+1)){
+                return false;
+            }
+        }
+        cut = minCut(gr);
+        return true;
+    }
+    // source side of the min cut between A and B, any solver with ff/cut/augmentations
+    template<typename Solver>
+    vector<int> minCut(){
+        Solver gr(fuzzyNodes, fuzzyEdges);
+        return minCut(gr);
+    }
+    template<typename Solver>
+    vector<int> minCut(Solver& gr){
+        int s = A.size()+B.size()+C.size();
+        {
+            ScopedPhase phase("ff");
+            gr.ff(s, s+1);
+        }
+        Profiler::global().set("augmenting_paths", gr.augmentations);
+        ScopedPhase phase("cut");
+        return gr.cut(s, s+1);
     }
     void simpleDecomposition(){
-        initProbs(2);
-        rep(probs,2);
+        unsigned int typen = initProbs(patches);
+        rep(probs,typen);
+    }
+    // the last fuzzyConstruct graph as a DIMACS max-flow instance; node i+1 is entry i
+    // of total, the comments map each node to its face
+    bool saveFuzzyDimacs(const string& path){
+        int s = A.size()+B.size()+C.size();
+        FlowGraph graph;
+        graph.build(fuzzyNodes, fuzzyEdges);
+        vector<string> comments;
+        comments.push_back("fuzzy region: A "+to_string(A.size())+", C "+to_string(C.size())+", B "+to_string(B.size())+" faces");
+        comments.push_back("source is total -1 (A side), sink is total -2 (B side)");
+        for(unsigned int i=0;i<total.size()-2;i++){
+            comments.push_back("face "+to_string(i+1)+" "+to_string(total.at(i)));
+        }
+        return saveDimacs(path, graph, s, s+1, comments);
+    }
+    // red and blue for the first two patches, the others step around the hue circle by
+    // the golden angle so neighbouring indices stay apart
+    static glm::vec3 patchColor(unsigned int type){
+        if(type<2){
+            return type ? glm::vec3(0,0,1) : glm::vec3(1,0,0);
+        }
+        float h = fmod(type*0.618034f, 1.0f)*6;
+        int sector = (int)h;
+        float f = h-sector;
+        switch(sector){
+        case 0: return glm::vec3(1,f,0);
+        case 1: return glm::vec3(1-f,1,0);
+        case 2: return glm::vec3(0,1,f);
+        case 3: return glm::vec3(0,1-f,1);
+        case 4: return glm::vec3(f,0,1);
+        default: return glm::vec3(1,0,1-f);
+        }
     }
     void saveAs(string output){
-        vector<glm::vec3> colors;
-        colors.push_back(glm::vec3(1,0,0));
-        colors.push_back(glm::vec3(0,0,1));
+        ScopedPhase phase("saveAs");
         ofstream fopt(output);
         // store vertice of faces and color
         unsigned int N = this->faces.size();
         for(unsigned int i=0;i<N;i++){
-            glm::vec3 color =  colors[faces[i].type];
+            glm::vec3 color =  patchColor(faces[i].type);
             for(unsigned int j=0;j<3;j++){
                 glm::vec3 pos = vertices[indices[i*3+j]].Position;
                 fopt<<"v "<<pos.x<<" "<<pos.y<<" "<<pos.z<<" "<<color.x<<" "<<color.y<<" "<<color.z<<endl;
@@ -449,54 +721,6 @@ public:
         }
         // store faces
     }
-private:
-    // render data 
-    unsigned int VBO, EBO;
-
-    // initializes all the buffer objects/arrays
-    void setupMesh()
-    {
-        // create buffers/arrays
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-        glGenBuffers(1, &EBO);
-
-        glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
-
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-		// ids
-		glEnableVertexAttribArray(5);
-		glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-		// weights
-		glEnableVertexAttribArray(6);
-		glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
-        glBindVertexArray(0);
-    }
 };
 #endif
 
@@ -0,0 +1,126 @@
+#include "meshdecomp.h"
+#include "model.h"
+#include "threadpool.h"
+#include "profiler.h"
+#include <sstream>
+
+static const char* modeName(DistanceMode mode){
+    if(mode==DENSE_FLOYD){
+        return "floyd";
+    }
+    if(mode==DENSE_DIJKSTRA){
+        return "dense";
+    }
+    return "sparse";
+}
+
+static const char* solverName(MaxFlowSolver solver){
+    if(solver==FORD_FULKERSON){
+        return "ff";
+    }
+    if(solver==PUSH_RELABEL){
+        return "pr";
+    }
+    if(solver==PARALLEL_PUSH_RELABEL){
+        return "ppr";
+    }
+    if(solver==DINIC){
+        return "dinic";
+    }
+    return "bk";
+}
+
+static const char* capacityName(CapacityMode mode){
+    if(mode==INT32_CAPACITY){
+        return "int32";
+    }
+    if(mode==INT64_CAPACITY){
+        return "int64";
+    }
+    return "float";
+}
+
+static const char* seedName(SeedMode mode){
+    if(mode==FARTHEST_PAIR){
+        return "pair";
+    }
+    return "sweep";
+}
+
+string sweepOutput(const string& output, float delta){
+    stringstream name;
+    size_t dot = output.rfind('.');
+    name<<output.substr(0, dot)<<".delta"<<delta;
+    if(dot!=string::npos){
+        name<<output.substr(dot);
+    }
+    return name.str();
+}
+
+bool decomposeFile(const string& input, const string& output, const DecompositionOptions& options){
+    ThreadPool::configure(options.threads);
+    Profiler& profiler = Profiler::global();
+    profiler.reset();
+    profiler.label("input", input);
+    profiler.label("distance_mode", modeName(options.distanceMode));
+    profiler.label("flow_solver", solverName(options.flowSolver));
+    // the dense FordFulkerson always runs on floats
+    CapacityMode capacity = options.flowSolver==FORD_FULKERSON ? FLOAT_CAPACITY : options.capacityMode;
+    profiler.label("capacity", capacityName(capacity));
+    profiler.set("threads", ThreadPool::global().size());
+    // sparse mode has no matrix to scan for the farthest pair
+    SeedMode seeds = options.distanceMode==SPARSE_DIJKSTRA ? DOUBLE_SWEEP : options.seedMode;
+    profiler.label("seed_mode", seedName(seeds));
+    bool loaded;
+    {
+        ScopedPhase phase("total");
+        Model model(input, true, false, options.distanceMode);
+        loaded = model.meshes.size()>0;
+        if(loaded){
+            model.meshes[0].flowSolver = options.flowSolver;
+            model.meshes[0].capacityMode = options.capacityMode;
+            model.meshes[0].capacityScale = options.capacityScale;
+            model.meshes[0].patches = options.patches;
+            model.meshes[0].maxPatches = options.maxPatches;
+            model.meshes[0].seedMode = seeds;
+            model.simple();
+            unsigned int typen = model.meshes[0].typeindex.size();
+            if(!options.sweep.empty() && typen>2){
+                cout<<"--sweep cuts two patches, refining "<<typen<<" by alpha expansion"<<endl;
+            }
+            // the sweep and the expansion always cut on their own Boykov-Kolmogorov over
+            // 64 bit capacities
+            if(!options.sweep.empty() || options.expansion || typen>2){
+                profiler.label("flow_solver", solverName(BOYKOV_KOLMOGOROV));
+                profiler.label("capacity", capacityName(INT64_CAPACITY));
+                if(options.solverGiven || options.capacityGiven){
+                    cout<<"--solver and --capacity only apply to the two way fuzzy cut, using bk on int64"<<endl;
+                }
+            }
+            if(!options.sweep.empty() && typen<=2){
+                Mesh& mesh = model.meshes[0];
+                vector<vector<unsigned int>> types = mesh.fuzzySweep(options.sweep);
+                for(unsigned int d=0;d<options.sweep.size();d++){
+                    for(unsigned int i=0;i<mesh.faces.size();i++){
+                        mesh.faces[i].type = types[d][i];
+                    }
+                    model.saveAs(sweepOutput(output, options.sweep[d]));
+                }
+            }else if(options.expansion || typen>2){
+                // two patches reach the energy of fuzzy(), not always its labels
+                model.meshes[0].fuzzyExpansion(typen);
+                model.saveAs(output);
+            }else{
+                model.fuzzy();
+                if(!options.dimacs.empty() && !model.meshes[0].saveFuzzyDimacs(options.dimacs)){
+                    cout<<"failed to write "<<options.dimacs<<endl;
+                }
+                model.saveAs(output);
+            }
+        }
+    }
+    if(!options.report.empty() && !profiler.save(options.report)){
+        cout<<"failed to write report "<<options.report<<endl;
+    }
+    return loaded;
+}
@@ -0,0 +1,54 @@
+#ifndef MESHDECOMP_H
+#define MESHDECOMP_H
+#include <string>
+#include <vector>
+#include "decomposition.h"
+#include "flowgraph.h"
+#include "seeding.h"
+using namespace std;
+// entry point of the headless decomposition library: load, decompose and save without
+// any window or GL context, shared by the meshdecomp cli and the viewer
+struct DecompositionOptions{
+    DistanceMode distanceMode;
+    MaxFlowSolver flowSolver;
+    // integer capacities are the fuzzy capacities times capacityScale
+    CapacityMode capacityMode;
+    double capacityScale;
+    // --solver or --capacity given, noted when the sweep or expansion ignores them
+    bool solverGiven;
+    bool capacityGiven;
+    // worker threads of the global pool, 0 for one per core
+    unsigned int threads;
+    // json file for the phase timings and counters, empty for none
+    string report;
+    // DIMACS max-flow dump of the fuzzy region graph, empty for none
+    string dimacs;
+    // fuzzy deltas cut in one warm started sweep instead of fuzzy(0.01), one output each
+    vector<float> sweep;
+    // refine the fuzzy boundaries of all patches by alpha expansion instead of fuzzy()
+    bool expansion;
+    // number of patches, 0 picks it from 2..maxPatches; more than two are always refined
+    // by alpha expansion
+    unsigned int patches;
+    unsigned int maxPatches;
+    // two way seeds with --dense or --floyd, sparse mode always sweeps
+    SeedMode seedMode;
+    DecompositionOptions(){
+        distanceMode = SPARSE_DIJKSTRA;
+        flowSolver = BOYKOV_KOLMOGOROV;
+        capacityMode = FLOAT_CAPACITY;
+        capacityScale = 65536;
+        solverGiven = false;
+        capacityGiven = false;
+        threads = 0;
+        expansion = false;
+        patches = 2;
+        maxPatches = 10;
+        seedMode = FARTHEST_PAIR;
+    }
+};
+// output of one sweep delta: "model.obj" becomes "model.delta0.05.obj"
+string sweepOutput(const string& output, float delta);
+// returns false if the model could not be loaded
+bool decomposeFile(const string& input, const string& output, const DecompositionOptions& options);
+#endif
@@ -0,0 +1,254 @@
+#ifndef MESHGEN_H
+#define MESHGEN_H
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <fstream>
+#include <unordered_map>
+#include <stdint.h>
+#include "mesh.h"
+using namespace std;
+// deterministic closed manifold test meshes of roughly a requested face count, used
+// by the benchmarks to chart scaling from 1k to 1M faces
+class MeshGenerator{
+public:
+    // parametric torus, rings*sides*2 faces
+    static Mesh torus(unsigned int targetFaces, float R=1.0f, float r=0.35f){
+        unsigned int sides = max(3u, (unsigned int)sqrt(targetFaces*r/(2*R)));
+        unsigned int rings = max(3u, targetFaces/(2*sides));
+        vector<glm::vec3> positions;
+        for(unsigned int i=0;i<rings;i++){
+            float u = 2*M_PI*i/rings;
+            for(unsigned int j=0;j<sides;j++){
+                float v = 2*M_PI*j/sides;
+                positions.push_back(glm::vec3((R+r*cos(v))*cos(u), (R+r*cos(v))*sin(u), r*sin(v)));
+            }
+        }
+        return fromTriangles(positions, grid(rings, sides));
+    }
+    // tube swept along a figure eight curve, the two lobes pass over each other at the
+    // crossing so the surface stays embedded
+    static Mesh figureEight(unsigned int targetFaces, float r=0.12f){
+        // the curve is about 6.5 long, keep the quads close to square
+        unsigned int sides = max(3u, (unsigned int)sqrt(targetFaces*M_PI*r/6.5f));
+        unsigned int rings = max(3u, targetFaces/(2*sides));
+        vector<glm::vec3> positions;
+        for(unsigned int i=0;i<rings;i++){
+            float t = 2*M_PI*i/rings;
+            glm::vec3 c = curve(t);
+            glm::vec3 tangent = glm::normalize(curve(t+1e-3f)-curve(t-1e-3f));
+            glm::vec3 normal = glm::normalize(glm::cross(tangent, glm::vec3(0, 0, 1)));
+            glm::vec3 binormal = glm::cross(tangent, normal);
+            for(unsigned int j=0;j<sides;j++){
+                float v = 2*M_PI*j/sides;
+                positions.push_back(c+r*(cos(v)*normal+sin(v)*binormal));
+            }
+        }
+        return fromTriangles(positions, grid(rings, sides));
+    }
+    // sphere with torus handles fused onto it, polygonized with marching tetrahedra;
+    // the grid is sized once from a trial run to land near targetFaces
+    static Mesh sphereWithHandles(unsigned int targetFaces, unsigned int handles=2){
+        unsigned int res = 16;
+        vector<glm::vec3> positions;
+        vector<unsigned int> indices;
+        polygonize(handles, res, positions, indices);
+        float scale = sqrt((float)targetFaces/max<size_t>(1, indices.size()/3));
+        res = max(8u, (unsigned int)(res*scale));
+        polygonize(handles, res, positions, indices);
+        return fromTriangles(positions, indices);
+    }
+    static Mesh generate(const string& shape, unsigned int targetFaces){
+        if(shape=="eight"){
+            return figureEight(targetFaces);
+        }
+        if(shape=="handles"){
+            return sphereWithHandles(targetFaces);
+        }
+        return torus(targetFaces);
+    }
+    // face normals the same way as Model::processMesh
+    static Mesh fromTriangles(const vector<glm::vec3>& positions, const vector<unsigned int>& indices){
+        vector<Vertex> vertices(positions.size(), Vertex());
+        for(unsigned int i=0;i<positions.size();i++){
+            vertices[i].Position = positions[i];
+        }
+        vector<Face> faces(indices.size()/3);
+        for(unsigned int i=0;i<faces.size();i++){
+            glm::vec3 e1 = positions[indices[i*3+1]]-positions[indices[i*3]];
+            glm::vec3 e2 = positions[indices[i*3+2]]-positions[indices[i*3+1]];
+            faces[i].Normal = glm::normalize(glm::cross(e1, e2));
+            faces[i].type = 0;
+        }
+        return Mesh(vertices, indices, vector<Texture>(), faces);
+    }
+    // shared vertex obj, what the loader benchmark reads back
+    static bool saveObj(const Mesh& mesh, const string& path){
+        ofstream out(path);
+        if(!out){
+            return false;
+        }
+        for(unsigned int i=0;i<mesh.vertices.size();i++){
+            glm::vec3 p = mesh.vertices[i].Position;
+            out<<"v "<<p.x<<" "<<p.y<<" "<<p.z<<"\n";
+        }
+        for(unsigned int i=0;i+2<mesh.indices.size();i+=3){
+            out<<"f "<<mesh.indices[i]+1<<" "<<mesh.indices[i+1]+1<<" "<<mesh.indices[i+2]+1<<"\n";
+        }
+        return true;
+    }
+private:
+    // quads of a rings*sides grid closed in both directions, two triangles each
+    static vector<unsigned int> grid(unsigned int rings, unsigned int sides){
+        vector<unsigned int> indices;
+        indices.reserve(rings*sides*6);
+        for(unsigned int i=0;i<rings;i++){
+            unsigned int i1 = (i+1)%rings;
+            for(unsigned int j=0;j<sides;j++){
+                unsigned int j1 = (j+1)%sides;
+                unsigned int a = i*sides+j, b = i1*sides+j, c = i1*sides+j1, d = i*sides+j1;
+                indices.push_back(a);
+                indices.push_back(b);
+                indices.push_back(c);
+                indices.push_back(a);
+                indices.push_back(c);
+                indices.push_back(d);
+            }
+        }
+        return indices;
+    }
+    // lemniscate of gerono, lifted at the crossing
+    static glm::vec3 curve(float t){
+        return glm::vec3(cos(t), sin(t)*cos(t), 0.3f*sin(t));
+    }
+    // positive inside: sphere smoothly joined with tori standing on its surface
+    static float field(unsigned int handles, glm::vec3 p){
+        float d = 0.8f-glm::length(p);
+        for(unsigned int h=0;h<handles;h++){
+            float a = 2*M_PI*h/handles;
+            glm::vec3 c(0.8f*cos(a), 0.8f*sin(a), 0);
+            glm::vec3 q = p-c;
+            // torus around the radial direction so it loops out of the sphere
+            glm::vec3 axis(-sin(a), cos(a), 0);
+            float along = glm::dot(q, axis);
+            float ring = glm::length(q-along*axis)-0.45f;
+            float t = 0.12f-sqrt(ring*ring+along*along);
+            // smooth max keeps the union free of creases
+            float k = 0.08f;
+            float blend = min(1.0f, max(0.0f, 0.5f+0.5f*(t-d)/k));
+            d = d*(1-blend)+t*blend+k*blend*(1-blend);
+        }
+        return d;
+    }
+    static void polygonize(unsigned int handles, unsigned int res, vector<glm::vec3>& positions, vector<unsigned int>& indices){
+        positions.clear();
+        indices.clear();
+        const float lo = -1.5f;
+        const float step = 3.0f/res;
+        unsigned int n = res+1;
+        vector<float> values((size_t)n*n*n);
+        for(unsigned int z=0;z<n;z++){
+            for(unsigned int y=0;y<n;y++){
+                for(unsigned int x=0;x<n;x++){
+                    float f = field(handles, glm::vec3(lo+x*step, lo+y*step, lo+z*step));
+                    // no grid point exactly on the surface, it would give zero area faces
+                    if(fabs(f)<1e-7f){
+                        f = 1e-7f;
+                    }
+                    values[((size_t)z*n+y)*n+x] = f;
+                }
+            }
+        }
+        unordered_map<uint64_t, unsigned int> edgeVertex;
+        // kuhn split of the cube into six tetrahedra along the 0-7 diagonal, the same
+        // split in every cube keeps neighbouring faces consistent
+        static const unsigned int tets[6][4] = {{0,1,3,7},{0,3,2,7},{0,2,6,7},{0,6,4,7},{0,4,5,7},{0,5,1,7}};
+        for(unsigned int z=0;z<res;z++){
+            for(unsigned int y=0;y<res;y++){
+                for(unsigned int x=0;x<res;x++){
+                    uint64_t corner[8];
+                    for(unsigned int c=0;c<8;c++){
+                        corner[c] = ((uint64_t)(z+(c>>2&1))*n+(y+(c>>1&1)))*n+(x+(c&1));
+                    }
+                    for(unsigned int t=0;t<6;t++){
+                        uint64_t v[4];
+                        for(unsigned int k=0;k<4;k++){
+                            v[k] = corner[tets[t][k]];
+                        }
+                        tetrahedron(v, values, n, lo, step, edgeVertex, positions, indices);
+                    }
+                }
+            }
+        }
+    }
+    static glm::vec3 gridPoint(uint64_t id, unsigned int n, float lo, float step){
+        unsigned int x = id%n;
+        unsigned int y = id/n%n;
+        unsigned int z = id/n/n;
+        return glm::vec3(lo+x*step, lo+y*step, lo+z*step);
+    }
+    static unsigned int crossing(uint64_t a, uint64_t b, const vector<float>& values, unsigned int n, float lo, float step, unordered_map<uint64_t, unsigned int>& edgeVertex, vector<glm::vec3>& positions){
+        if(a>b){
+            swap(a, b);
+        }
+        uint64_t key = a*(uint64_t)n*n*n+b;
+        unordered_map<uint64_t, unsigned int>::iterator it = edgeVertex.find(key);
+        if(it!=edgeVertex.end()){
+            return it->second;
+        }
+        float fa = values[a];
+        float fb = values[b];
+        float s = fa/(fa-fb);
+        positions.push_back(gridPoint(a, n, lo, step)*(1-s)+gridPoint(b, n, lo, step)*s);
+        unsigned int id = positions.size()-1;
+        edgeVertex[key] = id;
+        return id;
+    }
+    static void triangle(unsigned int a, unsigned int b, unsigned int c, glm::vec3 inside, vector<glm::vec3>& positions, vector<unsigned int>& indices){
+        glm::vec3 normal = glm::cross(positions[b]-positions[a], positions[c]-positions[a]);
+        // orient outwards, away from the inside corner of the tetrahedron
+        if(glm::dot(normal, positions[a]-inside)<0){
+            swap(b, c);
+        }
+        indices.push_back(a);
+        indices.push_back(b);
+        indices.push_back(c);
+    }
+    static void tetrahedron(const uint64_t* v, const vector<float>& values, unsigned int n, float lo, float step, unordered_map<uint64_t, unsigned int>& edgeVertex, vector<glm::vec3>& positions, vector<unsigned int>& indices){
+        unsigned int in[4], out[4];
+        unsigned int ni = 0, no = 0;
+        for(unsigned int k=0;k<4;k++){
+            if(values[v[k]]>0){
+                in[ni++] = k;
+            }else{
+                out[no++] = k;
+            }
+        }
+        if(ni==0 || no==0){
+            return;
+        }
+        if(ni==1 || no==1){
+            // one corner cut off
+            bool single = ni==1;
+            unsigned int apex = single ? in[0] : out[0];
+            const unsigned int* rest = single ? out : in;
+            unsigned int p[3];
+            for(unsigned int k=0;k<3;k++){
+                p[k] = crossing(v[apex], v[rest[k]], values, n, lo, step, edgeVertex, positions);
+            }
+            glm::vec3 inside = single ? gridPoint(v[apex], n, lo, step) : gridPoint(v[rest[0]], n, lo, step);
+            triangle(p[0], p[1], p[2], inside, positions, indices);
+            return;
+        }
+        // two and two, a quad split into two triangles
+        unsigned int p00 = crossing(v[in[0]], v[out[0]], values, n, lo, step, edgeVertex, positions);
+        unsigned int p01 = crossing(v[in[0]], v[out[1]], values, n, lo, step, edgeVertex, positions);
+        unsigned int p11 = crossing(v[in[1]], v[out[1]], values, n, lo, step, edgeVertex, positions);
+        unsigned int p10 = crossing(v[in[1]], v[out[0]], values, n, lo, step, edgeVertex, positions);
+        glm::vec3 inside = (gridPoint(v[in[0]], n, lo, step)+gridPoint(v[in[1]], n, lo, step))*0.5f;
+        triangle(p00, p01, p11, inside, positions, indices);
+        triangle(p00, p11, p10, inside, positions, indices);
+    }
+};
+#endif
@@ -3,17 +3,14 @@
 #ifndef MODEL_H
 #define MODEL_H
 
-#include <glad/glad.h> 
-
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
 #include "mesh.h"
-#include "shader.h"
+#include "profiler.h"
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -22,8 +19,6 @@
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
-
 class Model 
 {
 public:
@@ -32,19 +27,14 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    DistanceMode distanceMode;
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool joinvertice=false, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool joinvertice=false, bool gamma = false, DistanceMode mode = SPARSE_DIJKSTRA) : gammaCorrection(gamma), distanceMode(mode)
     {
         loadModel(path, joinvertice);
     }
     
-    // draws the model, and thus all its meshes
-    void Draw(Shader &shader)
-    {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
-    }
     void simple(){
         meshes[0].simpleDecomposition();
     }
@@ -61,10 +51,13 @@ private:
         // read file via ASSIMP
         Assimp::Importer importer;
         const aiScene* scene;
-        if(joinvertice)
-            scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace|aiProcess_JoinIdenticalVertices);
-        else
-            scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        {
+            ScopedPhase phase("import");
+            if(joinvertice)
+                scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace|aiProcess_JoinIdenticalVertices);
+            else
+                scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        }
 
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
@@ -96,7 +89,8 @@ private:
             meshes.push_back(processMesh(mesh, scene));
             // processFace(mesh);
             if (joinvertice){
-                processEdge(mesh);
+                meshes.back().distanceMode = distanceMode;
+                processEdge();
                 meshes.back().initWeights();
                 meshes.back().calcWeights();
             }
@@ -109,48 +103,18 @@ private:
 
     }
     
-    void processEdge(aiMesh *mesh){
-        unsigned int begin,end, sidev;
-        bool edgeleft;
-        meshes.back().edge2face = new vector<map<unsigned int, Edge>>(mesh->mNumVertices);
-        for(unsigned int i = 0; i < mesh->mNumFaces; i++){
-            aiFace* face = &(mesh->mFaces[i]);
-            for(unsigned int j=0;j<face->mNumIndices;j++){
-                // face对应的vertex
-                if(face->mIndices[j]<face->mIndices[(j+1)%3]){
-                    begin = face->mIndices[j];
-                    end = face->mIndices[(j+1)%3];
-                    sidev = face->mIndices[(j+2)%3];
-                    edgeleft = true;
-                }else{
-                    end = face->mIndices[j];
-                    begin = face->mIndices[(j+1)%3];
-                    sidev = face->mIndices[(j+2)%3];
-                    edgeleft = false;
-                }
-                if(meshes.back().edge2face->at(begin).count(end)>0){
-                    if(edgeleft){
-                        meshes.back().edge2face->at(begin)[end].left = i;
-                        meshes.back().edge2face->at(begin)[end].leftv = sidev;
-                    }
-                    else{
-                        meshes.back().edge2face->at(begin)[end].right = i;
-                        meshes.back().edge2face->at(begin)[end].rightv = sidev;
-                    }
-                }else{
-                    Edge edge;
-                    if(edgeleft){
-                        edge.left = i;
-                        edge.leftv = sidev;
-                    }
-                    else{
-                        edge.right = i;
-                        edge.rightv = sidev;
-                    }
-                    meshes.back().edge2face->at(begin)[end] = edge;
-                }
-            }
-        }
+    void processEdge(){
+        // pair up the half edges of the faces into the dual graph
+        ScopedPhase phase("processEdge");
+        Mesh& target = meshes.back();
+        DualBuilder builder;
+        builder.build(target.indices, target.dual, target.dualReport);
+        Profiler::global().count("faces", target.faces.size());
+        Profiler::global().count("vertices", target.vertices.size());
+        Profiler::global().count("edges", target.dual.edgeCount());
+        Profiler::global().count("boundary_edges", target.dualReport.boundary.size());
+        Profiler::global().count("non_manifold_edges", target.dualReport.nonManifold.size());
+        cout<<"edge number:"<<target.dual.edgeCount()<<" boundary:"<<target.dualReport.boundary.size()<<" non-manifold:"<<target.dualReport.nonManifold.size()<<endl;
     }
     void processFace(aiMesh *mesh){
         for(unsigned int i=0;i<mesh->mNumFaces;i++){
@@ -251,7 +215,7 @@ private:
         return Mesh(vertices, indices, textures, faces);
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
+    // checks all material textures of a given type and records the ones not seen yet.
     // the required info is returned as a Texture struct.
     vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
     {
@@ -272,9 +236,9 @@ private:
                 }
             }
             if(!skip)
-            {   // if texture hasn't been loaded already, load it
+            {   // only the path is recorded here, the viewer uploads it (renderer.h)
                 Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
+                texture.id = 0;
                 texture.type = typeName;
                 texture.path = str.C_Str();
                 textures.push_back(texture);
@@ -285,45 +249,5 @@ private:
     }
 };
 
-
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
-{
-    string filename = string(path);
-    filename = directory + '/' + filename;
-
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
 #endif
 
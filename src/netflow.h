@@ -3,78 +3,94 @@
 #include <vector>
 #include <list>
 #include <stack>//using for dfs
-#include <queue>//using for bfs
+#include <iostream>
+#include "matrix.h"
+#include "flowgraph.h"
+#include "bfs.h"
 using namespace std;
-class Node{
-public:
-    bool visited;// dfs时是否查找到
-    float deltaflow;//可增加的最大流
-    int parent;//来自哪里的增流路径
-};
 class FordFulkerson{
 public:
-    float** distance;
-    float** flow;
-    float** capacity;
+    Matrix<float> flow;
+    Matrix<float> capacity;
     vector<vector<int>> edges;
-    Node* nodes;
+    // edges[u] contains v for every u in incoming[v], for the bottom-up bfs levels
+    vector<vector<int>> incoming;
     int N;
-    FordFulkerson(float** distance, int N){
-        this->N = N;
-        this->distance = distance;
-        this->flow  = new float*[N];
-        this->capacity =  new float*[N];
+    // augmenting paths found by the last ff
+    unsigned int augmentations;
+    FordFulkerson(const Matrix<float>& distance){
+        build(distance);
+    }
+    // the dense matrices from an edge list, -1 where there is no edge
+    FordFulkerson(unsigned int n, const vector<FlowEdge>& edges){
+        Matrix<float> distance(n, n);
+        distance.fill(-1);
+        for(unsigned int i=0;i<edges.size();i++){
+            distance[edges[i].u][edges[i].v] = edges[i].cap;
+            distance[edges[i].v][edges[i].u] = edges[i].rcap;
+        }
+        build(distance);
+    }
+    void build(const Matrix<float>& distance){
+        this->N = distance.rows();
+        this->augmentations = 0;
+        this->flow = Matrix<float>(N, N);
+        this->capacity = Matrix<float>(N, N);
         this->edges.resize(N);
-        this->nodes = new Node[N];
+        this->incoming.resize(N);
         for(unsigned int i=0;i<N;i++){
-            this->flow[i] = new float[N];
-            this->capacity[i] = new float[N];
             for(unsigned int j=0;j<N;j++){
                 if(distance[i][j]!=-1){
                     this->flow[i][j] = 0;
                     this->capacity[i][j] = distance[i][j];
                     this->edges[i].push_back(j);
+                    this->incoming[j].push_back(i);
                 }
             }
         }
     }
-    void init(){
-        for(int i=0;i<this->N;i++){
-            this->nodes[i].visited = false;
-            this->nodes[i].deltaflow = 0;
-            this->nodes[i].parent = -1;
+    // residual arcs of the matrices for FrontierBfs
+    struct Residual{
+        const FordFulkerson& graph;
+        Residual(const FordFulkerson& graph) : graph(graph){}
+        unsigned int size() const{
+            return graph.N;
         }
-    }
-    bool findway(int s, int d){
-        // 寻找增流路径
-        queue<int> Q;
-        Q.push(s);
-        this->nodes[s].deltaflow = 1e10;
-        this->nodes[s].visited = true;
-        while(Q.size()>0){
-            int cur = Q.front();
-            Q.pop();
-            if(cur==d){
-                break;
+        unsigned int degree(unsigned int v) const{
+            return graph.edges[v].size();
+        }
+        template<typename Visit>
+        void out(unsigned int u, Visit visit) const{
+            for(unsigned int i=0;i<graph.edges[u].size();i++){
+                int v = graph.edges[u][i];
+                if(graph.capacity[u][v]>0){
+                    visit(v);
+                }
             }
-            for(int i=0;i<this->edges[cur].size();i++){
-                int v = this->edges[cur][i];
-                if(!this->nodes[v].visited && this->capacity[cur][v]>0){
-                    Q.push(v);
-                    this->nodes[v].visited = true;
-                    this->nodes[v].deltaflow = min(this->capacity[cur][v],this->nodes[cur].deltaflow);
-                    this->nodes[v].parent = cur;
+        }
+        template<typename Visit>
+        void in(unsigned int v, Visit visit) const{
+            for(unsigned int i=0;i<graph.incoming[v].size();i++){
+                int u = graph.incoming[v][i];
+                if(graph.capacity[u][v]>0 && visit(u)){
+                    return;
                 }
             }
         }
-        return this->nodes[d].visited;
+    };
+    bool findway(int s, int d){
+        // 寻找增流路径
+        return bfs.run(Residual(*this), s, d);
     }
     void updateway(int s, int d){
         //增流
+        float minflow = 1e10;
+        for(int v=d;v!=s;v=bfs.parent(v)){
+            minflow = min(minflow, this->capacity[bfs.parent(v)][v]);
+        }
         int v = d;
-        int minflow = this->nodes[v].deltaflow;
         while(v!=s){
-            int parent = this->nodes[v].parent;
+            int parent = bfs.parent(v);
             this->flow[parent][v] += minflow;
             this->capacity[parent][v] -= minflow;
             this->capacity[v][parent] += minflow;
@@ -82,10 +98,10 @@ public:
         }
     }
     void ff(int s, int d){
-        init();
+        augmentations = 0;
         while(findway(s, d)){
             updateway(s,d);
-            init();
+            augmentations++;
         }
     }
     void print(int s, int d){
@@ -96,29 +112,11 @@ public:
         }
     }
     vector<int> cut(int s, int d){
-        //从s出发，用bfs寻找对应的分割部分
-        init();
-        vector<int> spart;
-        queue<int> Q;
-        Q.push(s);
-        this->nodes[s].visited = true;
-        while(Q.size()>0){
-            int cur = Q.front();
-            Q.pop();
-            spart.push_back(cur);
-            if(cur==d){
-                break;
-            }
-            for(int i=0;i<this->edges[cur].size();i++){
-                int v = this->edges[cur][i];
-                if(!this->nodes[v].visited && this->capacity[cur][v]!=0&&this->flow[cur][v]>0){
-                    Q.push(v);
-                    this->nodes[v].visited = true;
-                    this->nodes[v].parent = cur;
-                }
-            }
-        }
-        return spart;
+        //从s出发，用bfs寻找对应的分割部分: reachable through unsaturated residual edges
+        bfs.run(Residual(*this), s, d);
+        return vector<int>(bfs.order.begin(), bfs.order.end());
     }
+private:
+    FrontierBfs bfs;
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,154 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <ostream>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+using namespace std;
+// per phase wall time, process cpu time and peak rss growth plus named counters,
+// written as one json object per run; phases with the same name are accumulated
+struct PhaseRecord{
+    string name;
+    unsigned int calls;
+    double wall;
+    double cpu;
+    // growth of the peak resident set while the phase ran, in KB
+    long peakRssDelta;
+    PhaseRecord(){
+        calls = 0;
+        wall = 0;
+        cpu = 0;
+        peakRssDelta = 0;
+    }
+};
+class Profiler{
+public:
+    // phases in the order they first ran
+    vector<PhaseRecord> phases;
+    map<string, long long> counters;
+    // run description: input file, distance mode ...
+    map<string, string> labels;
+
+    static Profiler& global(){
+        static Profiler profiler;
+        return profiler;
+    }
+    void reset(){
+        unique_lock<mutex> lock(guard);
+        phases.clear();
+        counters.clear();
+        labels.clear();
+    }
+    void addPhase(const string& name, double wall, double cpu, long peakRssDelta){
+        unique_lock<mutex> lock(guard);
+        unsigned int i = 0;
+        while(i<phases.size() && phases[i].name!=name){
+            i++;
+        }
+        if(i==phases.size()){
+            phases.push_back(PhaseRecord());
+            phases.back().name = name;
+        }
+        phases[i].calls++;
+        phases[i].wall += wall;
+        phases[i].cpu += cpu;
+        phases[i].peakRssDelta += peakRssDelta;
+    }
+    void count(const string& name, long long value=1){
+        unique_lock<mutex> lock(guard);
+        counters[name] += value;
+    }
+    void set(const string& name, long long value){
+        unique_lock<mutex> lock(guard);
+        counters[name] = value;
+    }
+    void label(const string& name, const string& value){
+        unique_lock<mutex> lock(guard);
+        labels[name] = value;
+    }
+    // peak resident set of the process in KB, 0 where it is not available
+    static long peakRss(){
+#ifdef _WIN32
+        return 0;
+#else
+        struct rusage usage;
+        if(getrusage(RUSAGE_SELF, &usage)!=0){
+            return 0;
+        }
+#ifdef __APPLE__
+        return usage.ru_maxrss/1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+    void writeJson(ostream& out){
+        unique_lock<mutex> lock(guard);
+        out<<"{\n  \"run\": {";
+        for(map<string, string>::iterator it=labels.begin();it!=labels.end();it++){
+            out<<(it==labels.begin() ? "\n" : ",\n");
+            out<<"    \""<<it->first<<"\": \""<<escape(it->second)<<"\"";
+        }
+        out<<"\n  },\n  \"phases\": [";
+        for(unsigned int i=0;i<phases.size();i++){
+            const PhaseRecord& p = phases[i];
+            out<<(i ? ",\n" : "\n");
+            out<<"    {\"name\": \""<<p.name<<"\", \"calls\": "<<p.calls<<", \"wall_s\": "<<p.wall
+               <<", \"cpu_s\": "<<p.cpu<<", \"peak_rss_delta_kb\": "<<p.peakRssDelta<<"}";
+        }
+        out<<"\n  ],\n  \"counters\": {";
+        for(map<string, long long>::iterator it=counters.begin();it!=counters.end();it++){
+            out<<(it==counters.begin() ? "\n" : ",\n");
+            out<<"    \""<<it->first<<"\": "<<it->second;
+        }
+        out<<"\n  },\n  \"peak_rss_kb\": "<<peakRss()<<"\n}\n";
+    }
+    bool save(const string& path){
+        ofstream out(path);
+        if(!out){
+            return false;
+        }
+        writeJson(out);
+        return true;
+    }
+private:
+    mutex guard;
+
+    static string escape(const string& s){
+        string out;
+        for(unsigned int i=0;i<s.size();i++){
+            if(s[i]=='"' || s[i]=='\\'){
+                out += '\\';
+            }
+            out += s[i];
+        }
+        return out;
+    }
+};
+// times the enclosing scope as one call of the named phase
+class ScopedPhase{
+public:
+    ScopedPhase(const char* name) : name(name){
+        rssStart = Profiler::peakRss();
+        cpuStart = clock();
+        wallStart = chrono::steady_clock::now();
+    }
+    ~ScopedPhase(){
+        double wall = chrono::duration<double>(chrono::steady_clock::now()-wallStart).count();
+        double cpu = (double)(clock()-cpuStart)/CLOCKS_PER_SEC;
+        Profiler::global().addPhase(name, wall, cpu, Profiler::peakRss()-rssStart);
+    }
+private:
+    const char* name;
+    chrono::steady_clock::time_point wallStart;
+    clock_t cpuStart;
+    long rssStart;
+};
+#endif
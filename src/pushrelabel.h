@@ -0,0 +1,403 @@
+#ifndef PUSHRELABEL_H
+#define PUSHRELABEL_H
+#include <vector>
+#include <queue>
+#include <atomic>
+#include "flowgraph.h"
+#include "threadpool.h"
+using namespace std;
+// exact distance labels from the residual graph: heights below n are distances to the
+// sink, nodes that cannot reach it get n plus their distance back to the source so their
+// excess returns there, 2n marks nodes reaching neither
+template<typename Cap>
+void globalHeights(const BasicFlowGraph<Cap>& graph, unsigned int s, unsigned int d, vector<unsigned int>& height){
+    unsigned int n = graph.size();
+    height.assign(n, 2*n);
+    height[d] = 0;
+    height[s] = n;
+    queue<unsigned int> Q;
+    for(unsigned int pass=0;pass<2;pass++){
+        Q.push(pass==0 ? d : s);
+        while(Q.size()>0){
+            unsigned int u = Q.front();
+            Q.pop();
+            for(unsigned int a=graph.begin(u);a<graph.end(u);a++){
+                unsigned int w = graph.heads[a];
+                // w -> u still has residual capacity
+                if(height[w]==2*n && graph.residual[graph.twins[a]]>0){
+                    height[w] = height[u]+1;
+                    Q.push(w);
+                }
+            }
+        }
+    }
+}
+// highest label push-relabel with global relabelling and the gap heuristic; the preflow
+// is turned into a flow in the same run (heights above n lead back to the source) so
+// cut returns the residual reachable set like FordFulkerson::cut
+template<typename Cap>
+class BasicPushRelabel{
+public:
+    BasicFlowGraph<Cap> graph;
+    // pushes of the last ff
+    unsigned int augmentations;
+    unsigned int relabels;
+    unsigned int globalRelabels;
+
+    BasicPushRelabel(){
+        augmentations = 0;
+    }
+    BasicPushRelabel(const Matrix<float>& distance){
+        graph.build(distance);
+        augmentations = 0;
+    }
+    BasicPushRelabel(unsigned int n, const vector<FlowEdge>& edges){
+        graph.build(n, edges);
+        augmentations = 0;
+    }
+    void ff(int s, int d){
+        n = graph.size();
+        source = s;
+        sink = d;
+        graph.reset();
+        excess.assign(n, 0);
+        current.assign(n, 0);
+        augmentations = 0;
+        relabels = 0;
+        globalRelabels = 0;
+        for(unsigned int a=graph.begin(s);a<graph.end(s);a++){
+            Cap f = graph.residual[a];
+            if(f>0){
+                graph.residual[a] = 0;
+                graph.residual[graph.twins[a]] += f;
+                excess[graph.heads[a]] += f;
+            }
+        }
+        globalRelabel();
+        while(true){
+            while(maxActive>0 && active[maxActive].empty()){
+                maxActive--;
+            }
+            if(active[maxActive].empty()){
+                break;
+            }
+            unsigned int v = active[maxActive].back();
+            active[maxActive].pop_back();
+            // stale entry: the node was lifted or already discharged
+            if(height[v]!=maxActive || excess[v]<=0){
+                continue;
+            }
+            discharge(v);
+            if(sinceGlobal>=n){
+                globalRelabel();
+            }
+        }
+    }
+    vector<int> cut(int s, int d){
+        return graph.sourceSide(s, d);
+    }
+private:
+    unsigned int n;
+    unsigned int source;
+    unsigned int sink;
+    vector<Cap> excess;
+    vector<unsigned int> height;
+    vector<unsigned int> current;
+    // active nodes by height, checked against height when popped
+    vector<vector<unsigned int>> active;
+    unsigned int maxActive;
+    // all nodes below n by height, doubly linked, for the gap heuristic
+    vector<int> bucketHead;
+    vector<int> bucketNext;
+    vector<int> bucketPrev;
+    unsigned int maxBucket;
+    unsigned int sinceGlobal;
+
+    void globalRelabel(){
+        globalHeights(graph, source, sink, height);
+        globalRelabels++;
+        sinceGlobal = 0;
+        active.assign(2*n+1, vector<unsigned int>());
+        maxActive = 0;
+        bucketHead.assign(n, -1);
+        bucketNext.assign(n, -1);
+        bucketPrev.assign(n, -1);
+        maxBucket = 0;
+        for(unsigned int v=0;v<n;v++){
+            current[v] = graph.begin(v);
+            if(v==source || v==sink){
+                continue;
+            }
+            if(height[v]<n){
+                link(v);
+            }
+            if(excess[v]>0 && height[v]<2*n){
+                activate(v);
+            }
+        }
+    }
+    void activate(unsigned int v){
+        active[height[v]].push_back(v);
+        if(height[v]>maxActive){
+            maxActive = height[v];
+        }
+    }
+    void link(unsigned int v){
+        unsigned int h = height[v];
+        bucketPrev[v] = -1;
+        bucketNext[v] = bucketHead[h];
+        if(bucketHead[h]>=0){
+            bucketPrev[bucketHead[h]] = v;
+        }
+        bucketHead[h] = v;
+        if(h>maxBucket){
+            maxBucket = h;
+        }
+    }
+    void unlink(unsigned int v){
+        unsigned int h = height[v];
+        if(bucketPrev[v]>=0){
+            bucketNext[bucketPrev[v]] = bucketNext[v];
+        }else{
+            bucketHead[h] = bucketNext[v];
+        }
+        if(bucketNext[v]>=0){
+            bucketPrev[bucketNext[v]] = bucketPrev[v];
+        }
+    }
+    void discharge(unsigned int v){
+        while(excess[v]>0){
+            if(current[v]==graph.end(v)){
+                relabel(v);
+                if(height[v]>=2*n){
+                    return;
+                }
+                continue;
+            }
+            unsigned int a = current[v];
+            unsigned int w = graph.heads[a];
+            if(graph.residual[a]>0 && height[v]==height[w]+1){
+                Cap f = min(excess[v], graph.residual[a]);
+                graph.residual[a] -= f;
+                graph.residual[graph.twins[a]] += f;
+                excess[v] -= f;
+                bool idle = excess[w]<=0;
+                excess[w] += f;
+                augmentations++;
+                if(idle && w!=source && w!=sink){
+                    activate(w);
+                }
+            }else{
+                current[v]++;
+            }
+        }
+    }
+    void relabel(unsigned int v){
+        unsigned int old = height[v];
+        unsigned int h = 2*n;
+        for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+            if(graph.residual[a]>0 && height[graph.heads[a]]+1<h){
+                h = height[graph.heads[a]]+1;
+            }
+        }
+        if(old<n){
+            unlink(v);
+        }
+        height[v] = h;
+        current[v] = graph.begin(v);
+        relabels++;
+        sinceGlobal++;
+        if(h<n){
+            link(v);
+        }
+        if(old<n && bucketHead[old]<0){
+            gap(old);
+        }
+    }
+    // nothing is left at height g, nodes above it cannot reach the sink any more
+    void gap(unsigned int g){
+        for(unsigned int h=g+1;h<=maxBucket && h<n;h++){
+            int v = bucketHead[h];
+            while(v>=0){
+                int next = bucketNext[v];
+                height[v] = n+1;
+                current[v] = graph.begin(v);
+                if(excess[v]>0){
+                    activate(v);
+                }
+                v = next;
+            }
+            bucketHead[h] = -1;
+        }
+        maxBucket = g;
+    }
+};
+typedef BasicPushRelabel<float> PushRelabel;
+// synchronous parallel push-relabel: every round all active nodes push along admissible
+// arcs against the heights of the previous round, then the ones left with excess are
+// relabelled; two neighbours can never push to each other in the same round, so each
+// arc has one writer and the result does not depend on the thread count
+template<typename Cap>
+class BasicParallelPushRelabel{
+public:
+    BasicFlowGraph<Cap> graph;
+    // pushes of the last ff
+    unsigned int augmentations;
+    unsigned int rounds;
+    unsigned int globalRelabels;
+
+    BasicParallelPushRelabel(){
+        augmentations = 0;
+    }
+    BasicParallelPushRelabel(const Matrix<float>& distance){
+        graph.build(distance);
+        augmentations = 0;
+    }
+    BasicParallelPushRelabel(unsigned int n, const vector<FlowEdge>& edges){
+        graph.build(n, edges);
+        augmentations = 0;
+    }
+    void ff(int s, int d){
+        ThreadPool& pool = ThreadPool::global();
+        unsigned int n = graph.size();
+        graph.reset();
+        vector<Cap> excess(n, 0);
+        vector<unsigned int> height;
+        vector<unsigned int> next(n);
+        // flow pushed over an arc this round, summed by the head afterwards
+        vector<Cap> pushed(graph.arcCount(), 0);
+        vector<atomic<bool>> received(n);
+        vector<unsigned char> listed(n, 0);
+        vector<vector<unsigned int>> touched(pool.size());
+        vector<vector<unsigned int>> left(pool.size());
+        vector<unsigned int> counts(pool.size());
+        augmentations = 0;
+        rounds = 0;
+        globalRelabels = 0;
+        for(unsigned int a=graph.begin(s);a<graph.end(s);a++){
+            Cap f = graph.residual[a];
+            if(f>0){
+                graph.residual[a] = 0;
+                graph.residual[graph.twins[a]] += f;
+                excess[graph.heads[a]] += f;
+            }
+        }
+        for(unsigned int v=0;v<n;v++){
+            received[v] = false;
+        }
+        vector<unsigned int> actives;
+        unsigned int sinceGlobal = n;
+        while(true){
+            if(sinceGlobal>=n){
+                globalHeights(graph, s, d, height);
+                globalRelabels++;
+                sinceGlobal = 0;
+                actives.clear();
+                for(unsigned int v=0;v<n;v++){
+                    if(v!=(unsigned int)s && v!=(unsigned int)d && excess[v]>0 && height[v]<2*n){
+                        actives.push_back(v);
+                    }
+                }
+            }
+            if(actives.empty()){
+                break;
+            }
+            rounds++;
+            for(unsigned int t=0;t<pool.size();t++){
+                touched[t].clear();
+                left[t].clear();
+                counts[t] = 0;
+            }
+            // push, only the tail writes an arc and its twin this round
+            pool.parallelFor(0, actives.size(), 256, [&](unsigned int begin, unsigned int end, unsigned int worker){
+                for(unsigned int i=begin;i<end;i++){
+                    unsigned int v = actives[i];
+                    Cap e = excess[v];
+                    for(unsigned int a=graph.begin(v);a<graph.end(v) && e>0;a++){
+                        unsigned int w = graph.heads[a];
+                        if(height[v]!=height[w]+1 || graph.residual[a]<=0){
+                            continue;
+                        }
+                        Cap f = min(e, graph.residual[a]);
+                        graph.residual[a] -= f;
+                        graph.residual[graph.twins[a]] += f;
+                        pushed[a] += f;
+                        e -= f;
+                        counts[worker]++;
+                        if(w!=(unsigned int)s && w!=(unsigned int)d && !received[w].exchange(true)){
+                            touched[worker].push_back(w);
+                        }
+                    }
+                    excess[v] = e;
+                    if(e>0){
+                        left[worker].push_back(v);
+                    }
+                }
+            });
+            vector<unsigned int> gained;
+            vector<unsigned int> stuck;
+            for(unsigned int t=0;t<pool.size();t++){
+                gained.insert(gained.end(), touched[t].begin(), touched[t].end());
+                stuck.insert(stuck.end(), left[t].begin(), left[t].end());
+                augmentations += counts[t];
+            }
+            // collect the incoming pushes, and relabel against the old heights
+            pool.parallelFor(0, gained.size(), 256, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int i=begin;i<end;i++){
+                    unsigned int w = gained[i];
+                    Cap in = 0;
+                    for(unsigned int a=graph.begin(w);a<graph.end(w);a++){
+                        in += pushed[graph.twins[a]];
+                        pushed[graph.twins[a]] = 0;
+                    }
+                    excess[w] += in;
+                    received[w] = false;
+                }
+            });
+            pool.parallelFor(0, stuck.size(), 256, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int i=begin;i<end;i++){
+                    unsigned int v = stuck[i];
+                    unsigned int h = 2*n;
+                    for(unsigned int a=graph.begin(v);a<graph.end(v);a++){
+                        if(graph.residual[a]>0 && height[graph.heads[a]]+1<h){
+                            h = height[graph.heads[a]]+1;
+                        }
+                    }
+                    next[v] = h;
+                }
+            });
+            // pushes into the terminals are not summed, only cleared
+            for(unsigned int a=graph.begin(s);a<graph.end(s);a++){
+                pushed[graph.twins[a]] = 0;
+            }
+            for(unsigned int a=graph.begin(d);a<graph.end(d);a++){
+                pushed[graph.twins[a]] = 0;
+            }
+            actives.clear();
+            for(unsigned int i=0;i<stuck.size();i++){
+                unsigned int v = stuck[i];
+                height[v] = next[v];
+                if(height[v]<2*n && !listed[v]){
+                    listed[v] = 1;
+                    actives.push_back(v);
+                }
+            }
+            for(unsigned int i=0;i<gained.size();i++){
+                unsigned int w = gained[i];
+                if(excess[w]>0 && height[w]<2*n && !listed[w]){
+                    listed[w] = 1;
+                    actives.push_back(w);
+                }
+            }
+            for(unsigned int i=0;i<actives.size();i++){
+                listed[actives[i]] = 0;
+            }
+            sinceGlobal += stuck.size();
+        }
+    }
+    vector<int> cut(int s, int d){
+        return graph.sourceSide(s, d);
+    }
+};
+typedef BasicParallelPushRelabel<float> ParallelPushRelabel;
+#endif
@@ -0,0 +1,192 @@
+#ifndef REPRESENTATIVE_H
+#define REPRESENTATIVE_H
+#include <vector>
+#include <algorithm>
+#include "threadpool.h"
+using namespace std;
+// the representative of a patch minimises W(face) = sum_k probs[k]*d(face,k) over the
+// candidate faces. An exact W needs the distance row of every candidate, so W is
+// estimated from a few landmark rows: landmarks are picked farthest point first, weighted
+// by probs, starting at the current representative, and the probability of every face
+// moves to its nearest landmark. The estimate is then off by at most the moved distance
+// E = sum_k probs[k]*d(k,landmark(k)), so the candidates are summed exactly in estimate
+// order until no estimate minus E is below the best exact sum, or verify ran out, and the
+// representative only moves to a face whose exact sum is smaller. Landmarks are capped at a
+// quarter of the candidates, and when the landmark and verify rows would be as many as the
+// candidates every candidate is summed exactly instead
+class RepresentativeSearch{
+public:
+    // at most this many landmark rows per search and candidates summed exactly
+    unsigned int landmarks;
+    unsigned int verify;
+    // summed over searches: candidates scanned, landmark rows, exactly summed rows, and
+    // the searches whose result the bound proved to be the best candidate
+    unsigned long long candidates;
+    unsigned long long landmarkRows;
+    unsigned long long exactRows;
+    unsigned long long certified;
+
+    RepresentativeSearch(){
+        landmarks = 64;
+        verify = 16;
+        candidates = 0;
+        landmarkRows = 0;
+        exactRows = 0;
+        certified = 0;
+    }
+    // probs of the N faces for one patch, candidate(face) tells the faces the
+    // representative may move to; row(face, buffer) returns the distances from face to all
+    // faces, in buffer or in storage of its own, and is called from the pool threads
+    template<typename Candidate, typename Row>
+    unsigned int search(const float* probs, unsigned int N, Candidate candidate, unsigned int current, Row row){
+        vector<unsigned int> faces;
+        for(unsigned int i=0;i<N;i++){
+            if(candidate(i) && i!=current){
+                faces.push_back(i);
+            }
+        }
+        candidates += faces.size();
+        if(faces.empty()){
+            return current;
+        }
+        buffers.resize(ThreadPool::global().size());
+        for(unsigned int t=0;t<buffers.size();t++){
+            buffers[t].resize(N);
+        }
+        unsigned int count = min(landmarks, (unsigned int)faces.size()/4);
+        vector<double> sums;
+        if(faces.size()<=count+verify){
+            faces.push_back(current);
+            exact(probs, N, faces, sums, row);
+            // current last, it only loses to a strictly smaller sum
+            unsigned int best = current;
+            double bestSum = sums.back();
+            for(unsigned int c=0;c+1<faces.size();c++){
+                if(sums[c]<bestSum){
+                    bestSum = sums[c];
+                    best = faces[c];
+                }
+            }
+            certified++;
+            return best;
+        }
+        double bound = estimate(probs, N, faces, current, count, row);
+        vector<unsigned int> order(faces.size());
+        for(unsigned int c=0;c<order.size();c++){
+            order[c] = c;
+        }
+        sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b){
+            return estimates[a]<estimates[b] || (estimates[a]==estimates[b] && a<b);
+        });
+        // current first, its row is usually cached
+        vector<unsigned int> batch(1, current);
+        exact(probs, N, batch, sums, row);
+        unsigned int best = current;
+        double bestSum = sums[0];
+        unsigned int next = 0;
+        unsigned int budget = verify;
+        while(next<order.size() && budget>0 && estimates[order[next]]-bound<bestSum){
+            // one candidate per thread each round
+            batch.clear();
+            while(next<order.size() && batch.size()<min(budget, (unsigned int)buffers.size()) && estimates[order[next]]-bound<bestSum){
+                batch.push_back(faces[order[next++]]);
+            }
+            budget -= batch.size();
+            exact(probs, N, batch, sums, row);
+            for(unsigned int c=0;c<batch.size();c++){
+                if(sums[c]<bestSum){
+                    bestSum = sums[c];
+                    best = batch[c];
+                }
+            }
+        }
+        if(next==order.size() || estimates[order[next]]-bound>=bestSum){
+            certified++;
+        }
+        return best;
+    }
+private:
+    // one distance row per thread
+    vector<vector<float>> buffers;
+    // the landmark estimate of W for every candidate, and the landmark to candidate
+    // distances it is summed from
+    vector<double> estimates;
+    vector<vector<float>> distances;
+
+    // the exact sums of faces, one row each
+    template<typename Row>
+    void exact(const float* probs, unsigned int N, const vector<unsigned int>& faces, vector<double>& sums, Row row){
+        sums.resize(faces.size());
+        ThreadPool::global().parallelFor(0, faces.size(), 1, [&](unsigned int begin, unsigned int end, unsigned int worker){
+            for(unsigned int c=begin;c<end;c++){
+                const float* d = row(faces[c], buffers[worker].data());
+                double sum = 0;
+                for(unsigned int k=0;k<N;k++){
+                    sum += probs[k]*d[k];
+                }
+                sums[c] = sum;
+            }
+        });
+        exactRows += faces.size();
+    }
+    // fills estimates for faces and returns the bound E on their error
+    template<typename Row>
+    double estimate(const float* probs, unsigned int N, const vector<unsigned int>& faces, unsigned int current, unsigned int landmarks, Row row){
+        ThreadPool& pool = ThreadPool::global();
+        // distance of every face to its nearest landmark so far, and that landmark
+        vector<float> nearest(N, 1e30f);
+        vector<unsigned int> owner(N, 0);
+        unsigned int count = 0;
+        unsigned int landmark = current;
+        while(true){
+            unsigned int l = count++;
+            const float* d = row(landmark, buffers[0].data());
+            landmarkRows++;
+            // only the distances to the candidates are kept for the estimates
+            distances.resize(max((unsigned int)distances.size(), count));
+            distances[l].resize(faces.size());
+            pool.parallelFor(0, faces.size(), 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+                for(unsigned int c=begin;c<end;c++){
+                    distances[l][c] = d[faces[c]];
+                }
+            });
+            unsigned int farthest = landmark;
+            float farthestWeight = 0;
+            for(unsigned int k=0;k<N;k++){
+                // unreachable faces are -1 like in the rest of the distance code
+                if(d[k]>=0 && d[k]<nearest[k]){
+                    nearest[k] = d[k];
+                    owner[k] = l;
+                }
+                if(nearest[k]<1e30f && probs[k]*nearest[k]>farthestWeight){
+                    farthestWeight = probs[k]*nearest[k];
+                    farthest = k;
+                }
+            }
+            if(count>=landmarks || farthestWeight==0){
+                break;
+            }
+            landmark = farthest;
+        }
+        vector<double> mass(count, 0);
+        double bound = 0;
+        for(unsigned int k=0;k<N;k++){
+            if(nearest[k]<1e30f){
+                mass[owner[k]] += probs[k];
+                bound += probs[k]*nearest[k];
+            }
+        }
+        estimates.resize(faces.size());
+        pool.parallelFor(0, faces.size(), 4096, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int c=begin;c<end;c++){
+                double sum = 0;
+                for(unsigned int l=0;l<count;l++){
+                    sum += mass[l]*distances[l][c];
+                }
+                estimates[c] = sum;
+            }
+        });
+        return bound;
+    }
+};
+#endif
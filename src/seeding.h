@@ -0,0 +1,153 @@
+#ifndef SEEDING_H
+#define SEEDING_H
+#include <vector>
+#include <utility>
+#include "threadpool.h"
+using namespace std;
+// seeds of a two way decomposition: the farthest pair of the dense matrix, exact but
+// N*N/2 reads, or the ends of an approximate diameter by repeated farthest sweeps
+enum SeedMode{
+    FARTHEST_PAIR,
+    DOUBLE_SWEEP
+};
+// approximate diameter: from any face go to the farthest face and sweep again from there
+// while the distance grows, one distance row per sweep; exact on trees and usually on the
+// tube like shapes we decompose
+class DoubleSweep{
+public:
+    // distance rows computed, and the distance between the two ends
+    unsigned int sweeps;
+    float distance;
+
+    DoubleSweep(){
+        sweeps = 0;
+        distance = 0;
+    }
+    // the two ends, from start; row(face) as in FarthestPointSeeds::pick
+    template<typename Row>
+    pair<unsigned int, unsigned int> run(unsigned int N, unsigned int start, Row row, unsigned int maxSweeps=10){
+        const float* d = row(start);
+        unsigned int to = farthest(d, N);
+        sweeps = 1;
+        distance = d[to];
+        pair<unsigned int, unsigned int> ends(start, to);
+        while(sweeps<maxSweeps){
+            d = row(to);
+            sweeps++;
+            unsigned int next = farthest(d, N);
+            // back at the other end: float sums make d(a,b) and d(b,a) differ in the last
+            // bit, which would otherwise bounce between the two until maxSweeps
+            if(next==ends.first || d[next]<=distance){
+                break;
+            }
+            distance = d[next];
+            ends = make_pair(to, next);
+            to = next;
+        }
+        return ends;
+    }
+private:
+    static unsigned int farthest(const float* d, unsigned int N){
+        unsigned int maxi = 0;
+        for(unsigned int i=1;i<N;i++){
+            if(d[i]>d[maxi]){
+                maxi = i;
+            }
+        }
+        return maxi;
+    }
+};
+// seeds of a k way decomposition by farthest point sampling: every new seed is the face
+// farthest from the seeds so far, so each seed costs the one distance row from it instead
+// of a scan of the N*N matrix for the farthest pair
+class FarthestPointSeeds{
+public:
+    // distance from seed j to the seeds before it when it was picked, the paper's G(j);
+    // gaps[0] is 0
+    vector<float> gaps;
+
+    // count seeds from first; row(face) returns the distances from face to all N faces,
+    // unreachable faces are -1 and are never picked. Stops early when every face is a seed
+    template<typename Row>
+    vector<unsigned int> pick(unsigned int N, unsigned int first, unsigned int count, Row row){
+        vector<unsigned int> seeds;
+        gaps.clear();
+        vector<float> nearest(N, -1);
+        unsigned int seed = first;
+        float gap = 0;
+        while(seeds.size()<count){
+            seeds.push_back(seed);
+            gaps.push_back(gap);
+            if(seeds.size()==count){
+                break;
+            }
+            const float* d = row(seed);
+            unsigned int farthest = seed;
+            gap = 0;
+            for(unsigned int i=0;i<N;i++){
+                if(d[i]>=0 && (nearest[i]<0 || d[i]<nearest[i])){
+                    nearest[i] = d[i];
+                }
+                if(nearest[i]>gap){
+                    gap = nearest[i];
+                    farthest = i;
+                }
+            }
+            if(gap==0){
+                break;
+            }
+            seed = farthest;
+        }
+        return seeds;
+    }
+    // the paper's cost sum_j sum_f P_j(f)*d(f,seed j) of the first k rows for every k in
+    // [1,rows.size()]. With P_j = (1/d_j)/sum_l 1/d_l a face adds k/sum_l 1/d_l, 0 at a
+    // seed, so one pass over the faces gives every k; blocks of faces are summed on the
+    // pool and added in block order
+    static vector<double> costs(const vector<const float*>& rows, unsigned int N){
+        unsigned int K = rows.size();
+        unsigned int grain = 4096;
+        unsigned int blocks = (N+grain-1)/grain;
+        vector<vector<double>> partial(blocks, vector<double>(K+1, 0));
+        ThreadPool::global().parallelFor(0, blocks, 1, [&](unsigned int begin, unsigned int end, unsigned int){
+            for(unsigned int b=begin;b<end;b++){
+                vector<double>& sums = partial[b];
+                for(unsigned int i=b*grain;i<N && i<(b+1)*grain;i++){
+                    double inverse = 0;
+                    bool seed = false;
+                    for(unsigned int k=1;k<=K;k++){
+                        float d = rows[k-1][i];
+                        seed = seed || d==0;
+                        inverse += d>0 ? 1.0/d : 0;
+                        if(!seed && inverse>0){
+                            sums[k] += k/inverse;
+                        }
+                    }
+                }
+            }
+        });
+        vector<double> total(K+1, 0);
+        for(unsigned int b=0;b<blocks;b++){
+            for(unsigned int k=1;k<=K;k++){
+                total[k] += partial[b][k];
+            }
+        }
+        return total;
+    }
+    // the k in [2,K-1] after which the cost stops falling fast: the largest drop into k
+    // minus the drop out of it; costs[k] for k in [1,K], K of at least 3
+    static unsigned int elbow(const vector<double>& costs){
+        unsigned int K = costs.size()-1;
+        unsigned int best = 2;
+        double bestBend = 0;
+        for(unsigned int k=2;k<K;k++){
+            double bend = (costs[k-1]-costs[k])-(costs[k]-costs[k+1]);
+            if(k==2 || bend>bestBend){
+                best = k;
+                bestBend = bend;
+            }
+        }
+        return best;
+    }
+};
+#endif
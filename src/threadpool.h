@@ -0,0 +1,166 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+using namespace std;
+// work stealing pool for parallel loops: a range is cut into chunks which are dealt
+// round robin to per worker queues, a worker pops its own queue from the back and
+// steals from the front of the others when it runs dry
+class ThreadPool{
+public:
+    // fn(begin, end, worker) handles [begin,end), worker is in [0,size())
+    typedef function<void(unsigned int, unsigned int, unsigned int)> RangeFn;
+    ThreadPool(unsigned int n=0){
+        if(n==0){
+            n = thread::hardware_concurrency();
+        }
+        if(n==0){
+            n = 1;
+        }
+        queues = vector<WorkQueue>(n);
+        stopped = false;
+        generation = 0;
+        job = NULL;
+        running = 0;
+        // the caller is worker 0
+        for(unsigned int i=1;i<n;i++){
+            workers.push_back(thread(&ThreadPool::loop, this, i));
+        }
+    }
+    ~ThreadPool(){
+        {
+            unique_lock<mutex> lock(jobMutex);
+            stopped = true;
+        }
+        wake.notify_all();
+        for(unsigned int i=0;i<workers.size();i++){
+            workers[i].join();
+        }
+    }
+    unsigned int size(){
+        return queues.size();
+    }
+    void parallelFor(unsigned int begin, unsigned int end, unsigned int grain, const RangeFn& fn){
+        if(begin>=end){
+            return;
+        }
+        if(grain==0){
+            grain = 1;
+        }
+        // nested loops and single thread pools run inline
+        if(insideWorker() || size()==1 || end-begin<=grain){
+            fn(begin, end, 0);
+            return;
+        }
+        unique_lock<mutex> callLock(callMutex);
+        unsigned int n = size();
+        unsigned int chunk = 0;
+        for(unsigned int b=begin;b<end;b+=grain){
+            unsigned int e = end-b>grain ? b+grain : end;
+            queues[chunk%n].tasks.push_back(make_pair(b, e));
+            chunk++;
+        }
+        {
+            unique_lock<mutex> lock(jobMutex);
+            job = &fn;
+            running = n-1;
+            generation++;
+        }
+        wake.notify_all();
+        work(0, fn);
+        unique_lock<mutex> lock(jobMutex);
+        done.wait(lock, [this]{ return running==0; });
+        job = NULL;
+    }
+    // process wide pool shared by the decomposition engines, sized on first use
+    static ThreadPool& global(){
+        static ThreadPool pool(globalSize());
+        return pool;
+    }
+    // worker count of the global pool, 0 for one per core; no effect once it exists
+    static void configure(unsigned int n){
+        globalSize() = n;
+    }
+private:
+    struct WorkQueue{
+        mutex lock;
+        deque<pair<unsigned int, unsigned int>> tasks;
+        WorkQueue(){}
+        WorkQueue(const WorkQueue&){}
+    };
+    vector<WorkQueue> queues;
+    vector<thread> workers;
+    mutex callMutex;
+    mutex jobMutex;
+    condition_variable wake;
+    condition_variable done;
+    bool stopped;
+    unsigned long generation;
+    const RangeFn* job;
+    unsigned int running;
+
+    static unsigned int& globalSize(){
+        static unsigned int n = 0;
+        return n;
+    }
+    static bool& insideWorker(){
+        static thread_local bool inside = false;
+        return inside;
+    }
+    bool next(unsigned int id, pair<unsigned int, unsigned int>& task){
+        unsigned int n = size();
+        {
+            unique_lock<mutex> lock(queues[id].lock);
+            if(queues[id].tasks.size()>0){
+                task = queues[id].tasks.back();
+                queues[id].tasks.pop_back();
+                return true;
+            }
+        }
+        for(unsigned int k=1;k<n;k++){
+            WorkQueue& victim = queues[(id+k)%n];
+            unique_lock<mutex> lock(victim.lock);
+            if(victim.tasks.size()>0){
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+    void work(unsigned int id, const RangeFn& fn){
+        insideWorker() = true;
+        pair<unsigned int, unsigned int> task;
+        while(next(id, task)){
+            fn(task.first, task.second, id);
+        }
+        insideWorker() = false;
+    }
+    void loop(unsigned int id){
+        unsigned long seen = 0;
+        while(true){
+            const RangeFn* fn;
+            {
+                unique_lock<mutex> lock(jobMutex);
+                wake.wait(lock, [this, seen]{ return stopped || generation!=seen; });
+                if(stopped){
+                    return;
+                }
+                seen = generation;
+                fn = job;
+            }
+            work(id, *fn);
+            {
+                unique_lock<mutex> lock(jobMutex);
+                running--;
+            }
+            done.notify_all();
+        }
+    }
+};
+#endif
@@ -0,0 +1,129 @@
+#ifndef TOPMEMBERSHIP_H
+#define TOPMEMBERSHIP_H
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include "matrix.h"
+using namespace std;
+// the m largest memberships of every face for decompositions with many patches, instead of
+// the dense typen*N probs. Slot major structure of arrays: slot s of face i is at s*N+i,
+// slots of a face in decreasing probability, each a 16 bit patch and a 16 bit probability
+// in steps of 1/65535; the fuzzy region only needs the best two. The memberships add up
+// slowly (inverse distances), so the slots alone hold about half of a face's mass; the sum
+// of reciprocal distances of every face is kept too, and any membership is recomputed from
+// the distance row of its seed exactly as the dense kernel computed it.
+// 4*m+4 bytes per face instead of 4*typen, on top of the 4*typen of the seed rows that
+// row() reads
+class TopMemberships{
+public:
+    TopMemberships(){
+        patches = 0;
+        slotCount = 0;
+        faceCount = 0;
+    }
+    void resize(unsigned int typen, unsigned int N, unsigned int m){
+        patches = typen;
+        slotCount = m<typen ? m : typen;
+        faceCount = N;
+        labels.assign((size_t)slotCount*N, 0);
+        values.assign((size_t)slotCount*N, 0);
+        totals.assign(N, 0);
+    }
+    void release(){
+        resize(0, 0, 0);
+        labels.shrink_to_fit();
+        values.shrink_to_fit();
+        totals.shrink_to_fit();
+    }
+    bool empty() const{
+        return slotCount==0;
+    }
+    unsigned int typen() const{
+        return patches;
+    }
+    unsigned int slots() const{
+        return slotCount;
+    }
+    unsigned int label(unsigned int s, unsigned int i) const{
+        return labels[(size_t)s*faceCount+i];
+    }
+    float value(unsigned int s, unsigned int i) const{
+        return values[(size_t)s*faceCount+i]*(1.0f/65535);
+    }
+    size_t bytes() const{
+        return labels.size()*sizeof(unsigned short)+values.size()*sizeof(unsigned short)+totals.size()*sizeof(float);
+    }
+    // keeps the largest slots of faces [begin,end) from their dense probs and the seed
+    // rows they came from, probs[j][c] and rows[j][c] for face begin+c; ties go to the
+    // lower patch like the labels
+    void store(unsigned int begin, unsigned int end, const float* const* rows, const float* const* probs){
+        vector<float> best(slotCount);
+        vector<unsigned int> patch(slotCount);
+        for(unsigned int i=begin;i<end;i++){
+            // summed in patch order like the kernels, so the same bits
+            float total = 0;
+            for(unsigned int j=0;j<patches;j++){
+                total += 1/rows[j][i-begin];
+            }
+            totals[i] = total;
+            unsigned int filled = 0;
+            for(unsigned int j=0;j<patches;j++){
+                float p = probs[j][i-begin];
+                if(filled==slotCount && !(p>best[filled-1])){
+                    continue;
+                }
+                unsigned int s = filled<slotCount ? filled++ : filled-1;
+                while(s>0 && p>best[s-1]){
+                    best[s] = best[s-1];
+                    patch[s] = patch[s-1];
+                    s--;
+                }
+                best[s] = p;
+                patch[s] = j;
+            }
+            for(unsigned int s=0;s<slotCount;s++){
+                size_t at = (size_t)s*faceCount+i;
+                labels[at] = patch[s];
+                values[at] = (unsigned short)(best[s]>0 ? best[s]*65535+0.5f : 0);
+            }
+        }
+    }
+    // the membership row of patch j from the distance row of its seed, the bits of the
+    // dense probs[j]; a seed face belongs to its first slot alone
+    void row(unsigned int j, const float* seedRow, float* out) const{
+        const float inf = numeric_limits<float>::infinity();
+        for(unsigned int i=0;i<faceCount;i++){
+            out[i] = totals[i]==inf ? (label(0, i)==j) : (1/seedRow[i])/totals[i];
+        }
+    }
+private:
+    unsigned int patches;
+    unsigned int slotCount;
+    unsigned int faceCount;
+    vector<unsigned short> labels;
+    vector<unsigned short> values;
+    vector<float> totals;
+};
+// the dense probs through the slot interface of TopMemberships: every patch is a slot, in
+// patch order, so code written against slots runs on either storage
+class DenseMemberships{
+public:
+    DenseMemberships(const Matrix<float>& probs, unsigned int typen) : probs(probs), patches(typen){
+    }
+    unsigned int typen() const{
+        return patches;
+    }
+    unsigned int slots() const{
+        return patches;
+    }
+    unsigned int label(unsigned int s, unsigned int) const{
+        return s;
+    }
+    float value(unsigned int s, unsigned int i) const{
+        return probs[s][i];
+    }
+private:
+    const Matrix<float>& probs;
+    unsigned int patches;
+};
+#endif